@@ -0,0 +1,97 @@
+#ifndef EVENTMSG_BENCH_H
+#define EVENTMSG_BENCH_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// Heap allocations since start, counted by the malloc wrapper in bench_main.cpp
+extern std::atomic<uint64_t> allocations;
+
+struct Metric {
+    std::string name;   // e.g. "frames_per_sec"
+    double value;
+};
+
+struct Result {
+    std::string name;   // e.g. "process/clean/128"
+    std::vector<Metric> metrics;
+};
+
+struct Measurement {
+    uint64_t ops = 0;
+    double seconds = 0;
+    uint64_t allocs = 0;
+
+    double nsPerOp() const { return ops ? seconds * 1e9 / ops : 0; }
+    double opsPerSec() const { return seconds > 0 ? ops / seconds : 0; }
+    double allocsPerOp() const { return ops ? (double)allocs / ops : 0; }
+};
+
+class Context {
+public:
+    double minSeconds = 0.25;   // Per measurement; --quick lowers it
+
+    // Call op() in growing batches until minSeconds have passed
+    template <typename Op>
+    Measurement measure(Op&& op) const {
+        using clock = std::chrono::steady_clock;
+        Measurement m;
+        uint64_t batch = 1;
+        uint64_t allocStart = allocations.load(std::memory_order_relaxed);
+        auto start = clock::now();
+        while (true) {
+            for (uint64_t i = 0; i < batch; i++) op();
+            m.ops += batch;
+            m.seconds = std::chrono::duration<double>(clock::now() - start).count();
+            if (m.seconds >= minSeconds) break;
+            if (batch < (1u << 20)) batch *= 2;
+        }
+        m.allocs = allocations.load(std::memory_order_relaxed) - allocStart;
+        return m;
+    }
+
+    // Time a block that does its own looping and reports how many ops it did
+    template <typename Block>
+    Measurement time(Block&& block) const {
+        using clock = std::chrono::steady_clock;
+        Measurement m;
+        uint64_t allocStart = allocations.load(std::memory_order_relaxed);
+        auto start = clock::now();
+        m.ops = block();
+        m.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        m.allocs = allocations.load(std::memory_order_relaxed) - allocStart;
+        return m;
+    }
+
+    void report(const std::string& name, std::vector<Metric> metrics);
+
+    std::vector<Result> results;
+};
+
+using CaseFn = void (*)(Context&);
+
+struct Registrar {
+    Registrar(const char* name, CaseFn fn);
+};
+
+std::vector<std::pair<const char*, CaseFn>>& registry();
+
+// Payload of `length` printable bytes with `density` (0..1) of them
+// replaced by protocol control characters; deterministic per arguments
+std::vector<uint8_t> makePayload(size_t length, double density, uint32_t seed = 1);
+
+} // namespace bench
+
+#define BENCH_CASE(id)                                                   \
+    static void bench_##id(bench::Context& ctx);                         \
+    static bench::Registrar bench_registrar_##id(#id, bench_##id);       \
+    static void bench_##id(bench::Context& ctx)
+
+#endif // EVENTMSG_BENCH_H
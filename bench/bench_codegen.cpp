@@ -0,0 +1,139 @@
+// Generated static dispatch (tools/eventgen.py) against EventDispatcher
+#include "Bench.h"
+
+#ifdef EVENTMSG_BENCH_CATALOG
+
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+#include "GreenhouseEvents.h"
+
+namespace {
+
+using namespace greenhouse;
+
+struct Counter : Handlers {
+    uint64_t hits[EVENT_COUNT + 1] = {};
+
+    void onTelemetry(const Telemetry&, EventHeader&) { hits[TELEMETRY]++; }
+    void onRelaySet(const RelaySet&, EventHeader&) { hits[RELAY_SET]++; }
+    void onRelayState(const RelayState&, EventHeader&) { hits[RELAY_STATE]++; }
+    void onConfigName(const ConfigName&, EventHeader&) { hits[CONFIG_NAME]++; }
+    void onLog(const char*, size_t, EventHeader&) { hits[LOG]++; }
+    void onOtaChunk(const char*, size_t, EventHeader&) { hits[OTA_CHUNK]++; }
+    void onPing(EventHeader&) { hits[PING]++; }
+    void onReboot(EventHeader&) { hits[REBOOT]++; }
+};
+
+// The same handlers registered by name, the way firmware does it today
+void registerByName(EventDispatcher& dispatcher, uint64_t* hits) {
+    dispatcher.on("telemetry", [hits](const char*, size_t, EventHeader&) { hits[TELEMETRY]++; });
+    dispatcher.on("relay/set", [hits](const char*, size_t, EventHeader&) { hits[RELAY_SET]++; });
+    dispatcher.on("relay/state", [hits](const char*, size_t, EventHeader&) { hits[RELAY_STATE]++; });
+    dispatcher.on("config/name", [hits](const char*, size_t, EventHeader&) { hits[CONFIG_NAME]++; });
+    dispatcher.on("log", [hits](const char*, size_t, EventHeader&) { hits[LOG]++; });
+    dispatcher.on("ota/chunk", [hits](const char*, size_t, EventHeader&) { hits[OTA_CHUNK]++; });
+    dispatcher.on("ping", [hits](const char*, size_t, EventHeader&) { hits[PING]++; });
+    dispatcher.on("reboot", [hits](const char*, size_t, EventHeader&) { hits[REBOOT]++; });
+}
+
+}  // namespace
+
+BENCH_CASE(codegen) {
+    const EventHeader listen{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0};
+    const char payload[32] = {};
+
+    // Startup: registering the catalog's handlers with a fresh EventMsg
+    {
+        uint64_t hits[EVENT_COUNT + 1] = {};
+        auto byName = ctx.measure([&] {
+            EventMsg node;
+            EventDispatcher dispatcher;
+            registerByName(dispatcher, hits);
+            dispatcher.registerWith(node, "bench");
+        });
+        Counter counter;
+        auto generated = ctx.measure([&] {
+            EventMsg node;
+            registerWith(node, "bench", listen, counter);
+        });
+        auto bare = ctx.measure([&] { EventMsg node; });
+
+        ctx.report("codegen/startup", {
+            {"by_name_ns", byName.nsPerOp() - bare.nsPerOp()},
+            {"by_name_allocs", byName.allocsPerOp() - bare.allocsPerOp()},
+            {"generated_ns", generated.nsPerOp() - bare.nsPerOp()},
+            {"generated_allocs", generated.allocsPerOp() - bare.allocsPerOp()},
+        });
+    }
+
+    // Per event: name to handler, cycling through the catalog
+    {
+        uint64_t hits[EVENT_COUNT + 1] = {};
+        EventDispatcher dispatcher;
+        registerByName(dispatcher, hits);
+        Counter counter;
+        EventHeader header{0x02, 0x01, 0x00, 0};
+
+        uint16_t id = 1;
+        auto byName = ctx.measure([&] {
+            dispatcher.dispatchEvent(eventName(id), payload, sizeof(payload), header);
+            if (++id > EVENT_COUNT) id = 1;
+        });
+        auto generated = ctx.measure([&] {
+            dispatch(counter, eventName(id), payload, sizeof(payload), header);
+            if (++id > EVENT_COUNT) id = 1;
+        });
+        uint64_t unknown = 0;
+        auto miss = ctx.measure([&] {
+            unknown += dispatch(counter, "sensor/other", payload, sizeof(payload), header) ? 0 : 1;
+        });
+
+        ctx.report("codegen/dispatch", {
+            {"by_name_ns", byName.nsPerOp()},
+            {"generated_ns", generated.nsPerOp()},
+            {"generated_miss_ns", miss.nsPerOp()},
+            {"generated_allocs", generated.allocsPerOp()},
+        });
+    }
+
+    // Sender to Counter through real frames: every event arrives once
+    {
+        EventMsg tx;
+        EventMsg rx;
+        tx.setAddr(0x01);
+        rx.setAddr(0x02);
+        EventSourceId source = rx.createDirectSource();
+        tx.setWriteCallback([&](uint8_t* data, size_t len) { return rx.process(source, data, len); });
+        Counter counter;
+        registerWith(rx, "bench", listen, counter);
+
+        Sender sender(tx, EventHeader{0x01, 0x02, 0x00, 0});
+        RelayState relays = {};
+        ConfigName config = {};
+        strncpy(config.name, "greenhouse-node-07", sizeof(config.name));
+        const uint8_t chunk[64] = {};
+        auto m = ctx.measure([&] {
+            sender.telemetry(23.5f, 48.2f, 3912, -61, 86400);
+            sender.relaySet(3, true);
+            sender.relayState(relays);
+            sender.configName(config);
+            sender.log("sensor read ok");
+            sender.otaChunk(chunk, sizeof(chunk));
+            sender.ping();
+            sender.reboot();
+        });
+
+        bool even = sender.isValid();
+        for (size_t i = 2; i <= EVENT_COUNT; i++) {
+            even = even && counter.hits[i] == counter.hits[1];
+        }
+        ctx.report("codegen/round_trip", {
+            {"ns_per_message", m.nsPerOp() / EVENT_COUNT},
+            {"allocs_per_message", m.allocsPerOp() / EVENT_COUNT},
+            {"all_delivered", even && counter.hits[1] == m.ops ? 1.0 : 0.0},
+        });
+        rx.removeSource(source);
+    }
+}
+
+#endif // EVENTMSG_BENCH_CATALOG
@@ -0,0 +1,113 @@
+// Payload compression: ratio, bytes on air and CPU per KB
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventLzss.h"
+
+#include <string>
+
+namespace {
+
+struct Sample {
+    const char* name;
+    std::string payload;
+};
+
+// Shaped like what the firmware sends: a config dump, a batch of log
+// lines, a telemetry record, and random bytes as the incompressible case
+std::vector<Sample> samples() {
+    std::vector<Sample> result;
+
+    std::string config = "{\"device\":{\"name\":\"greenhouse-node-07\",\"fw\":\"2.4.1\",\"addr\":7,\"group\":2},"
+                         "\"wifi\":{\"ssid\":\"farm-iot\",\"channel\":6,\"power\":78,\"reconnect_ms\":5000},"
+                         "\"sensors\":[";
+    for (int i = 0; i < 8; i++) {
+        config += std::string(i ? "," : "") + "{\"id\":" + std::to_string(i) +
+                  ",\"type\":\"" + (i % 2 ? "humidity" : "temperature") +
+                  "\",\"interval_ms\":" + std::to_string(1000 * (i + 1)) +
+                  ",\"offset\":0.0,\"scale\":1.0,\"enabled\":true}";
+    }
+    config += "],\"mqtt\":{\"host\":\"10.0.0.2\",\"port\":1883,\"keepalive\":60}}";
+    result.push_back({"config_json", config});
+
+    std::string logs;
+    const char* levels[] = {"INFO", "WARN", "INFO", "DEBUG"};
+    const char* messages[] = {"sensor read ok", "retrying mqtt connect", "queue depth 3/8", "heap free 81234"};
+    for (int i = 0; i < 12; i++) {
+        logs += "[" + std::to_string(120345 + i * 250) + "][" + levels[i % 4] + "][EventMsg] " + messages[(i * 3) % 4] + "\n";
+    }
+    result.push_back({"log_lines", logs});
+
+    result.push_back({"telemetry_json", "{\"t\":23.51,\"h\":48.2,\"p\":1013.2,\"bat\":3.91,\"rssi\":-61,\"up\":86400}"});
+
+    auto random = bench::makePayload(256, 0.0, 7);
+    std::string noise;
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < random.size(); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        noise.push_back((char)(x & 0xFF));
+    }
+    result.push_back({"random", noise});
+    return result;
+}
+
+}  // namespace
+
+BENCH_CASE(compress) {
+    for (const auto& sample : samples()) {
+        const uint8_t* raw = (const uint8_t*)sample.payload.data();
+        size_t rawLen = sample.payload.size();
+
+        std::vector<uint8_t> packed(rawLen);
+        std::vector<uint8_t> unpacked(MAX_EVENT_DATA_SIZE);
+        size_t packedLen = EventLzss::compress(raw, rawLen, packed.data(), rawLen - 1);
+
+        auto compress = ctx.measure([&] {
+            EventLzss::compress(raw, rawLen, packed.data(), rawLen - 1);
+        });
+        double decompressNs = 0;
+        bool roundTrip = packedLen == 0;
+        if (packedLen != 0) {
+            size_t outLen = EventLzss::decompress(packed.data(), packedLen, unpacked.data(), unpacked.size());
+            roundTrip = outLen == rawLen && memcmp(unpacked.data(), raw, rawLen) == 0;
+            decompressNs = ctx.measure([&] {
+                EventLzss::decompress(packed.data(), packedLen, unpacked.data(), unpacked.size());
+            }).nsPerOp();
+        }
+
+        // Whole frames, stuffing and CRC-16 included, and back through the parser
+        EventMsg node;
+        node.setAddr(0x01);
+        node.setCrcMode(EVENT_FLAG_CRC16);
+        EventHeader header{0x01, 0x02, 0x00, 0};
+        PSRAMVector<uint8_t> plainFrame;
+        PSRAMVector<uint8_t> packedFrame;
+        size_t plainLen = node.encodeFrame("config", raw, rawLen, header, 1, plainFrame);
+        header.flags |= EVENT_FLAG_COMPRESSED;
+        size_t packedFrameLen = node.encodeFrame("config", raw, rawLen, header, 1, packedFrame);
+
+        EventMsg receiver;
+        bool intact = false;
+        receiver.registerDispatcher("check", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [&](const char*, const char*, const char* data, size_t length, EventHeader& h) {
+                intact = length == rawLen && memcmp(data, raw, rawLen) == 0 && !(h.flags & EVENT_FLAG_COMPRESSED);
+            });
+        EventSourceId source = receiver.createDirectSource();
+        auto parse = ctx.measure([&] {
+            receiver.process(source, packedFrame.data(), packedFrameLen);
+        });
+        receiver.removeSource(source);
+
+        double kb = rawLen / 1024.0;
+        ctx.report(std::string("compress/") + sample.name, {
+            {"raw_bytes", (double)rawLen},
+            {"ratio", packedLen ? (double)rawLen / packedLen : 1.0},
+            {"air_bytes_saved", (double)plainLen - (double)packedFrameLen},
+            {"compress_us_per_kb", compress.nsPerOp() / 1000 / kb},
+            {"decompress_us_per_kb", decompressNs / 1000 / kb},
+            {"receive_us", parse.nsPerOp() / 1000},
+            {"intact", intact && roundTrip ? 1.0 : 0.0},
+        });
+    }
+}
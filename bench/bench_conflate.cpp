@@ -0,0 +1,109 @@
+// High-rate telemetry under overload: every sample vs latest-value-wins
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventConflate.h"
+
+#include <atomic>
+#include <string>
+
+static const size_t senders = 4;
+
+// A handler that cannot keep up with the link: fixed CPU work per call
+static void slowHandler(std::atomic<uint64_t>& handled) {
+    static std::atomic<uint32_t> sink{0};
+    uint32_t x = (uint32_t)handled.fetch_add(1, std::memory_order_relaxed) | 1;
+    for (int i = 0; i < 5000; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    sink.fetch_add(x, std::memory_order_relaxed);
+}
+
+// A backlog: `count` sensordata frames round-robin over the senders
+static std::vector<uint8_t> buildBacklog(size_t count) {
+    EventMsg encoder;
+    PSRAMVector<uint8_t> frame;
+    std::vector<uint8_t> stream;
+    for (size_t i = 0; i < count; i++) {
+        std::string value = std::to_string(20.0 + (double)i / 100);
+        EventHeader header{(uint8_t)(0x10 + i % senders), 0x01, 0x00, 0};
+        size_t len = encoder.encodeFrame("sensordata", (const uint8_t*)value.data(), value.size(), header,
+                                         encoder.nextMsgId(), frame);
+        stream.insert(stream.end(), frame.begin(), frame.begin() + len);
+    }
+    return stream;
+}
+
+BENCH_CASE(conflate) {
+    const EventHeader listen{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0};
+
+    // Receive: the consumer fell behind by `backlog` frames
+    for (size_t backlog : {8, 64, 512}) {
+        auto stream = buildBacklog(backlog);
+        for (bool conflated : {false, true}) {
+            EventMsg node;
+            node.setAddr(0x01);
+            std::atomic<uint64_t> handled{0};
+            node.registerDispatcher("bench", listen,
+                [&handled](const char*, const char*, const char*, size_t, EventHeader&) { slowHandler(handled); });
+            EventSourceId source = node.createDirectSource();
+
+            Conflator conflator(node);
+            if (conflated) {
+                conflator.setConflated("sensordata");
+                conflator.begin("conflate");
+            }
+
+            auto m = ctx.time([&] {
+                node.process(source, stream.data(), stream.size());
+                conflator.dispatch();
+                return (uint64_t)backlog;
+            });
+
+            ctx.report(std::string("conflate/rx/") + (conflated ? "latest/" : "every/") + std::to_string(backlog), {
+                {"ns_per_frame", m.nsPerOp()},
+                {"handler_calls_per_frame", (double)handled.load() / m.ops},
+                {"allocs_per_frame", m.allocsPerOp()},
+            });
+            node.removeSource(source);
+        }
+    }
+
+    // Send: a producer at `rate` samples per flush of the link
+    for (size_t rate : {1, 10, 100}) {
+        for (bool conflated : {false, true}) {
+            EventMsg node;
+            node.setAddr(0x01);
+            uint64_t frames = 0;
+            uint64_t bytes = 0;
+            node.setWriteCallback([&](uint8_t*, size_t length) {
+                frames++;
+                bytes += length;
+                return true;
+            });
+            Conflator conflator(node);
+            EventHeader header{0x01, 0x02, 0x00, 0};
+
+            uint64_t samples = 0;
+            auto m = ctx.time([&] {
+                for (size_t i = 0; i < rate; i++) {
+                    std::string value = std::to_string(20.0 + (double)(samples++ % 1000) / 100);
+                    if (conflated) {
+                        conflator.sendConflated("sensordata", value.c_str(), header);
+                    } else {
+                        node.send("sensordata", value.c_str(), header);
+                    }
+                }
+                conflator.flush();
+                return (uint64_t)rate;
+            });
+
+            ctx.report(std::string("conflate/tx/") + (conflated ? "latest/" : "every/") + std::to_string(rate), {
+                {"ns_per_sample", m.nsPerOp()},
+                {"frames_per_sample", (double)frames / samples},
+                {"wire_bytes_per_sample", (double)bytes / samples},
+            });
+        }
+    }
+}
@@ -0,0 +1,112 @@
+// Corrupted frames: how many the CRC trailer rejects, and how many slip through
+#include "Bench.h"
+#include "EventMsg.h"
+
+#include <string>
+
+namespace {
+
+struct Mode {
+    const char* name;
+    uint8_t crc;
+    bool required;
+};
+
+const Mode modes[] = {
+    {"none", 0, false},
+    {"crc16", EVENT_FLAG_CRC16, false},
+    {"crc16_required", EVENT_FLAG_CRC16, true},
+    {"crc32", EVENT_FLAG_CRC32, false},
+    {"crc32_required", EVENT_FLAG_CRC32, true},
+};
+
+struct Damage {
+    const char* name;
+    size_t bits;    // Single bits flipped at random positions
+    size_t burst;   // Or: this many consecutive bytes scrambled
+};
+
+const Damage damages[] = {
+    {"1bit", 1, 0},
+    {"3bit", 3, 0},
+    {"burst4", 0, 4},
+    {"burst16", 0, 16},
+};
+
+uint32_t next(uint32_t& x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+}  // namespace
+
+BENCH_CASE(crc) {
+    const size_t trials = ctx.minSeconds < 0.1 ? 20000 : 200000;
+    auto payload = bench::makePayload(64, 0.02, 5);
+    const std::string name = "sensor/temp";
+
+    for (const Mode& mode : modes) {
+        EventMsg encoder;
+        EventHeader header{0x02, 0x01, 0x00, mode.crc};
+        PSRAMVector<uint8_t> frame;
+        size_t frameLen = encoder.encodeFrame(name.c_str(), payload.data(), payload.size(), header, 7, frame);
+        frame.resize(frameLen);
+
+        for (const Damage& damage : damages) {
+            EventMsg receiver;
+            receiver.setCrcRequired(mode.required);
+            uint64_t intact = 0;
+            uint64_t corrupt = 0;
+            receiver.registerDispatcher("check", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+                [&](const char*, const char* eventName, const char* data, size_t length, EventHeader& h) {
+                    bool same = name == eventName && length == payload.size() &&
+                                memcmp(data, payload.data(), length) == 0 &&
+                                h.senderId == header.senderId && h.receiverId == header.receiverId &&
+                                h.groupId == header.groupId && h.msgId == 7;
+                    if (same) {
+                        intact++;
+                    } else {
+                        corrupt++;
+                    }
+                });
+            EventSourceId source = receiver.createDirectSource();
+
+            uint32_t rng = 0x2545F491;
+            std::vector<uint8_t> trial(frameLen + 1);
+            uint64_t damaged = 0;
+            for (size_t t = 0; t < trials; t++) {
+                // A leading SOH resets the parser whatever the last trial left behind
+                trial[0] = SOH;
+                memcpy(trial.data() + 1, frame.data(), frameLen);
+                uint8_t* body = trial.data() + 1;
+                if (damage.bits) {
+                    for (size_t i = 0; i < damage.bits; i++) {
+                        uint32_t bit = next(rng) % (frameLen * 8);
+                        body[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+                    }
+                } else {
+                    size_t at = next(rng) % (frameLen - damage.burst + 1);
+                    for (size_t i = 0; i < damage.burst; i++) {
+                        body[at + i] = (uint8_t)next(rng);
+                    }
+                }
+                // A burst can rewrite bytes with what was there
+                if (memcmp(body, frame.data(), frameLen) == 0) continue;
+                damaged++;
+                receiver.process(source, trial.data(), trial.size());
+            }
+            receiver.removeSource(source);
+
+            // undetected: delivered, but not as sent. intact: the damage
+            // only hit bits the frame does not depend on (the hop count).
+            ctx.report(std::string("crc/") + mode.name + "/" + damage.name, {
+                {"rejected_pct", 100.0 * (damaged - intact - corrupt) / damaged},
+                {"undetected_pct", 100.0 * corrupt / damaged},
+                {"intact_pct", 100.0 * intact / damaged},
+                {"crc_errors", (double)receiver.getCrcErrorCount()},
+            });
+        }
+    }
+}
@@ -0,0 +1,103 @@
+// Duplicate filter: window hits and misses, sender table overflow, skipped flags
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDedupe.h"
+
+BENCH_CASE(dedupe) {
+    EventMsg node;
+
+    // Every frame arrives twice, the copy up to 8 frames late, as over two
+    // links with different delays
+    {
+        DuplicateFilter filter(node, 16);
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint16_t msgId = 0;
+        auto m = ctx.measure([&] {
+            if (filter.check(0x02, msgId)) hits++; else misses++;
+            if (filter.check(0x02, (uint16_t)(msgId - 8))) hits++; else misses++;
+            msgId++;
+        });
+        const DuplicateFilter::Stats& stats = filter.getStats();
+        ctx.report("dedupe/window", {
+            {"ns_per_check", m.nsPerOp() / 2},
+            // The first 8 late copies predate the stream and count as new
+            {"hit_rate", (double)hits / (m.ops - 8)},
+            {"misses_per_frame", (double)misses / m.ops},
+            {"resets", (double)stats.resets},
+        });
+    }
+
+    // Window edges: 63 back is still remembered, 64 back is a restart
+    {
+        DuplicateFilter filter(node, 16);
+        for (uint16_t id = 0; id < 200; id++) filter.check(0x02, id);
+        bool inside = filter.check(0x02, 199 - 63);
+        bool outside = filter.check(0x02, 199 - 64);
+        bool reset = filter.getStats().resets == 1;
+        ctx.report("dedupe/window_edges", {
+            {"hit_at_63", inside ? 1.0 : 0.0},
+            {"miss_at_64", !outside && reset ? 1.0 : 0.0},
+        });
+    }
+
+    // More senders than table slots: evicted senders start over, so their
+    // duplicates get through
+    for (size_t senders : {4, 8, 32}) {
+        DuplicateFilter filter(node, 8);
+        uint64_t hits = 0;
+        uint16_t msgId = 0;
+        // One round: a frame from every sender, then the copy of each
+        auto m = ctx.measure([&] {
+            for (size_t s = 1; s <= senders; s++) filter.check((uint8_t)s, msgId);
+            for (size_t s = 1; s <= senders; s++) {
+                if (filter.check((uint8_t)s, msgId)) hits++;
+            }
+            msgId++;
+        });
+        ctx.report("dedupe/senders/" + std::to_string(senders), {
+            {"table_slots", 8},
+            {"ns_per_frame", m.nsPerOp() / (2 * senders)},
+            {"hit_rate", (double)hits / (m.ops * senders)},
+            {"evictions", (double)filter.getStats().evictions},
+        });
+    }
+
+    // Through the parser: plain repeats are dropped; RESPONSE and RELIABLE
+    // frames reuse msgIds legitimately and are passed on
+    {
+        EventMsg receiver;
+        DuplicateFilter filter(receiver, 16);
+        filter.begin("dedupe");
+        uint64_t delivered[3] = {};
+        receiver.registerDispatcher("check", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [&](const char*, const char*, const char*, size_t, EventHeader& header) {
+                if (header.flags & EVENT_FLAG_RESPONSE) {
+                    delivered[1]++;
+                } else if (header.flags & EVENT_FLAG_RELIABLE) {
+                    delivered[2]++;
+                } else {
+                    delivered[0]++;
+                }
+            });
+        EventSourceId source = receiver.createDirectSource();
+
+        EventMsg encoder;
+        const uint8_t flags[] = {0, EVENT_FLAG_RESPONSE, EVENT_FLAG_RELIABLE};
+        const int copies = 4;
+        for (uint8_t flag : flags) {
+            PSRAMVector<uint8_t> frame;
+            size_t len = encoder.encodeFrame("sensor", (const uint8_t*)"1", 1, EventHeader{0x02, 0x01, 0x00, flag}, 500, frame);
+            for (int i = 0; i < copies; i++) {
+                receiver.process(source, frame.data(), len);
+            }
+        }
+        receiver.removeSource(source);
+        ctx.report("dedupe/flags", {
+            {"plain_delivered", (double)delivered[0]},
+            {"response_delivered", (double)delivered[1]},
+            {"reliable_delivered", (double)delivered[2]},
+            {"copies_each", (double)copies},
+        });
+    }
+}
@@ -0,0 +1,133 @@
+// Parsing with bursty handlers: inline dispatch vs DeferredDispatch
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDeferred.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+// Every 32nd event costs its handler ~200us, like a Serial.printf burst
+static void burstyHandler(std::atomic<uint64_t>& handled) {
+    if (handled.fetch_add(1, std::memory_order_relaxed) % 32 == 31) {
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+}
+
+static std::vector<uint8_t> buildStream(size_t count) {
+    EventMsg encoder;
+    auto payload = bench::makePayload(64, 0.01);
+    EventHeader header{0x02, 0x01, 0x00, 0};
+    PSRAMVector<uint8_t> frame;
+    std::vector<uint8_t> stream;
+    for (size_t i = 0; i < count; i++) {
+        size_t len = encoder.encodeFrame("sensor", payload.data(), payload.size(), header,
+                                         encoder.nextMsgId(), frame);
+        stream.insert(stream.end(), frame.begin(), frame.begin() + len);
+    }
+    return stream;
+}
+
+// Longest single process() call: how long the link goes unread
+static double feed(EventMsg& node, EventSourceId source, const std::vector<uint8_t>& stream) {
+    double worst = 0;
+    for (size_t pos = 0; pos < stream.size(); pos += RawPacket::MAX_SIZE) {
+        size_t chunk = stream.size() - pos < RawPacket::MAX_SIZE ? stream.size() - pos : RawPacket::MAX_SIZE;
+        auto start = std::chrono::steady_clock::now();
+        node.process(source, stream.data() + pos, chunk);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (us > worst) worst = us;
+    }
+    return worst;
+}
+
+BENCH_CASE(deferred) {
+    const size_t count = 64;
+    auto stream = buildStream(count);
+    const EventHeader listen{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0};
+
+    for (bool deferred : {false, true}) {
+        EventMsg node;
+        node.setAddr(0x01);
+        std::atomic<uint64_t> handled{0};
+        node.registerDispatcher("bench", listen,
+            [&handled](const char*, const char*, const char*, size_t, EventHeader&) { burstyHandler(handled); });
+        EventSourceId source = node.createDirectSource();
+
+        DeferredDispatch queue(node, DeferredDispatch::Config(count));
+        if (deferred) queue.begin("deferred");
+
+        // Same thread, stages timed apart: rx is what the link sees
+        double rxSeconds = 0;
+        double dispatchSeconds = 0;
+        double worstStall = 0;
+        uint64_t batches = 0;
+        auto m = ctx.time([&] {
+            auto until = std::chrono::steady_clock::now() + std::chrono::duration<double>(ctx.minSeconds);
+            while (std::chrono::steady_clock::now() < until) {
+                auto start = std::chrono::steady_clock::now();
+                double stall = feed(node, source, stream);
+                auto parsed = std::chrono::steady_clock::now();
+                queue.dispatch();
+                auto done = std::chrono::steady_clock::now();
+                rxSeconds += std::chrono::duration<double>(parsed - start).count();
+                dispatchSeconds += std::chrono::duration<double>(done - parsed).count();
+                if (stall > worstStall) worstStall = stall;
+                batches++;
+            }
+            return batches * count;
+        });
+
+        ctx.report(std::string("deferred/") + (deferred ? "queued" : "inline"), {
+            {"rx_ns_per_frame", rxSeconds * 1e9 / m.ops},
+            {"dispatch_ns_per_frame", dispatchSeconds * 1e9 / m.ops},
+            {"rx_stall_us_max", worstStall},
+            {"allocs_per_frame", m.allocsPerOp()},
+            {"delivered", (double)handled.load() / m.ops},
+        });
+        node.removeSource(source);
+    }
+
+    // Parser and handlers on separate threads, as on two cores
+    {
+        EventMsg node;
+        node.setAddr(0x01);
+        std::atomic<uint64_t> handled{0};
+        node.registerDispatcher("bench", listen,
+            [&handled](const char*, const char*, const char*, size_t, EventHeader&) { burstyHandler(handled); });
+        EventSourceId source = node.createDirectSource();
+        DeferredDispatch queue(node, DeferredDispatch::Config(256));
+        queue.begin("deferred");
+
+        const uint64_t rounds = ctx.minSeconds < 0.1 ? 20 : 200;
+        std::atomic<bool> done{false};
+        auto m = ctx.time([&] {
+            std::thread dispatcher([&] {
+                queue.setNotifyTask(xTaskGetCurrentTaskHandle());
+                while (!done.load() || queue.pending() > 0) {
+                    ulTaskNotifyTake(pdTRUE, 10);
+                    queue.dispatch();
+                }
+            });
+            // Pace the link: 64 frames per ms, well above the handlers' mean cost
+            for (uint64_t r = 0; r < rounds; r++) {
+                auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+                feed(node, source, stream);
+                std::this_thread::sleep_until(next);
+            }
+            done = true;
+            dispatcher.join();
+            return rounds * count;
+        });
+
+        auto stats = queue.getStats();
+        ctx.report("deferred/task", {
+            {"frames_per_sec", m.opsPerSec()},
+            {"dropped", (double)stats.dropped},
+            {"queue_high_water", (double)stats.highWater},
+            {"delivered", (double)handled.load() / m.ops},
+        });
+        node.removeSource(source);
+    }
+}
@@ -0,0 +1,115 @@
+// Dispatch cost against the number of registered handlers and events
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+static const size_t counts[] = {1, 10, 100, 1000};
+
+BENCH_CASE(dispatch) {
+    const uint8_t payload[] = "23.5";
+    const EventHeader listen{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0};
+
+    // One dispatcher, N event names; delivery cycles through all of them
+    for (size_t count : counts) {
+        EventMsg node;
+        node.init([](uint8_t*, size_t) { return true; });
+        EventDispatcher dispatcher;
+        uint64_t hits = 0;
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; i++) {
+            names.push_back("event" + std::to_string(i));
+            dispatcher.on(names.back().c_str(), [&hits](const char*, size_t, EventHeader&) { hits++; });
+        }
+        dispatcher.registerWith(node, "bench");
+
+        size_t next = 0;
+        auto m = ctx.measure([&] {
+            EventHeader header{0x02, BROADCAST_ADDR, 0x00, 0};
+            node.deliver(names[next].c_str(), payload, sizeof(payload) - 1, header);
+            if (++next == count) next = 0;
+        });
+        ctx.report("dispatch/events/" + std::to_string(count), {
+            {"ns_per_op", m.nsPerOp()},
+            {"allocs_per_op", m.allocsPerOp()},
+        });
+    }
+
+    // N dispatchers registered with EventMsg, each seeing every event
+    for (size_t count : counts) {
+        if (count > 100) break;   // Each one runs per event; 1000 says nothing new
+        EventMsg node;
+        node.init([](uint8_t*, size_t) { return true; });
+        uint64_t hits = 0;
+        for (size_t i = 0; i < count; i++) {
+            node.registerDispatcher(("dispatcher" + std::to_string(i)).c_str(), listen,
+                [&hits](const char*, const char*, const char*, size_t, EventHeader&) { hits++; });
+        }
+
+        auto m = ctx.measure([&] {
+            EventHeader header{0x02, BROADCAST_ADDR, 0x00, 0};
+            node.deliver("sensor", payload, sizeof(payload) - 1, header);
+        });
+        ctx.report("dispatch/dispatchers/" + std::to_string(count), {
+            {"ns_per_op", m.nsPerOp()},
+            {"ns_per_handler", m.nsPerOp() / count},
+            {"allocs_per_op", m.allocsPerOp()},
+        });
+    }
+}
+
+// Dispatch while another thread keeps registering and unregistering a
+// dispatcher and EventDispatcher handlers, as when subsystems come and go
+BENCH_CASE(dispatch_churn) {
+    const uint8_t payload[] = "23.5";
+    const EventHeader listen{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0};
+
+    for (bool churn : {false, true}) {
+        EventMsg node;
+        node.init([](uint8_t*, size_t) { return true; });
+        EventDispatcher dispatcher;
+        std::atomic<uint64_t> hits{0};
+        for (size_t i = 0; i < 10; i++) {
+            node.registerDispatcher(("dispatcher" + std::to_string(i)).c_str(), listen,
+                [&hits](const char*, const char*, const char*, size_t, EventHeader&) { hits++; });
+        }
+        dispatcher.on("sensor", [&hits](const char*, size_t, EventHeader&) { hits++; });
+        dispatcher.registerWith(node, "bench");
+
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> changes{0};
+        std::thread writer;
+        if (churn) {
+            writer = std::thread([&] {
+                uint64_t n = 0;
+                while (!done.load()) {
+                    node.registerDispatcher("hotplug", listen,
+                        [](const char*, const char*, const char*, size_t, EventHeader&) {});
+                    dispatcher.on(("hot" + std::to_string(n++ % 8)).c_str(),
+                        [](const char*, size_t, EventHeader&) {});
+                    node.unregisterDispatcher("hotplug");
+                    changes += 3;
+                    std::this_thread::yield();
+                }
+            });
+        }
+
+        uint64_t before = hits.load();
+        auto m = ctx.measure([&] {
+            EventHeader header{0x02, BROADCAST_ADDR, 0x00, 0};
+            node.deliver("sensor", payload, sizeof(payload) - 1, header);
+        });
+        done = true;
+        if (writer.joinable()) writer.join();
+
+        // The 11 fixed handlers must see every event no matter what churns
+        ctx.report(std::string("dispatch/churn/") + (churn ? "on" : "off"), {
+            {"ns_per_op", m.nsPerOp()},
+            {"handlers_missed", (double)(m.ops * 11 - (hits.load() - before))},
+            {"table_updates", (double)changes.load()},
+        });
+    }
+}
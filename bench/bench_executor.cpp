@@ -0,0 +1,85 @@
+// CPU-heavy handlers inline vs on an EventExecutor pool
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+static const size_t senders = 8;
+
+// Fixed CPU work rather than a wall-clock wait, which would overlap on a
+// preempted thread and flatter the pool
+static void burn(uint32_t rounds) {
+    static std::atomic<uint32_t> sink{0};
+    uint32_t x = rounds | 1;
+    for (uint32_t i = 0; i < rounds; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    sink.fetch_add(x, std::memory_order_relaxed);
+}
+
+static void runPool(bench::Context& ctx, const std::string& name, uint8_t workers, const ExecPolicy& policy) {
+    const uint32_t total = ctx.minSeconds < 0.1 ? 2000 : 20000;
+    const uint16_t slots = 64;
+
+    EventMsg node;
+    EventDispatcher dispatcher;
+    EventExecutor pool(EventExecutor::Config(workers, slots));
+    dispatcher.setExecutor(&pool);
+    dispatcher.registerWith(node, "bench");
+
+    // Each event carries a per-sender sequence number; ordered policies
+    // must see them strictly increasing
+    std::atomic<uint32_t> lastSeq[senders];
+    for (auto& seq : lastSeq) seq = 0;
+    std::atomic<uint32_t> handled{0};
+    std::atomic<uint32_t> reordered{0};
+    dispatcher.on("work", [&](const char* data, size_t, EventHeader& header) {
+        burn(20000);  // ~20us
+        uint32_t seq;
+        memcpy(&seq, data, sizeof(seq));
+        uint32_t previous = lastSeq[header.senderId].exchange(seq);
+        if (seq < previous) reordered++;
+        handled++;
+    }, policy);
+
+    if (policy.mode != ExecPolicy::INLINE) pool.start();
+    auto m = ctx.time([&] {
+        uint32_t seq[senders] = {};
+        for (uint32_t i = 0; i < total; i++) {
+            // Stay under the slab so nothing is dropped
+            while (pool.isRunning() && pool.pending() >= slots - 1) std::this_thread::yield();
+            uint8_t sender = (uint8_t)(i % senders);
+            uint32_t value = ++seq[sender];
+            EventHeader header{sender, BROADCAST_ADDR, 0x00, 0};
+            node.deliver("work", (const uint8_t*)&value, sizeof(value), header);
+        }
+        while (pool.pending() > 0) std::this_thread::yield();
+        return (uint64_t)total;
+    });
+    auto stats = pool.getStats();
+    pool.stop();
+
+    ctx.report("executor/" + name, {
+        {"events_per_sec", m.opsPerSec()},
+        {"handled", (double)handled.load() / total},
+        {"reordered", (double)reordered.load()},
+        {"stolen", (double)stats.stolen},
+        {"dropped", (double)stats.dropped},
+    });
+}
+
+BENCH_CASE(executor) {
+    // Throughput scales with cores, not workers; this host reports its count
+    runPool(ctx, "inline", 1, ExecPolicy::inlined());
+    for (uint8_t workers : {1, 2, 4}) {
+        runPool(ctx, "sender/" + std::to_string(workers), workers, ExecPolicy::pooled(ExecPolicy::ORDER_SENDER));
+    }
+    runPool(ctx, "unordered/4", 4, ExecPolicy::pooled());
+    runPool(ctx, "pinned0/4", 4, ExecPolicy::pinned(0, ExecPolicy::ORDER_SENDER));
+    ctx.report("executor/cores", {{"hardware_threads", (double)std::thread::hardware_concurrency()}});
+}
@@ -0,0 +1,109 @@
+// Producer faster than consumer over a loopback link, with and without
+// XON/XOFF flow control
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventFlow.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+
+static void runOverload(bench::Context& ctx, bool flowControl) {
+    // Receiver B parses from a queued source; sender A gets B's replies
+    // through a byte pipe that its own thread drains, like a UART
+    SourceQueueManager receiverQueues;
+    EventMsg sender;
+    EventMsg receiver(receiverQueues);
+    std::mutex pipeLock;
+    std::vector<uint8_t> pipe;
+
+    EventSourceId fromSender = receiver.createSource();
+    receiver.setAddr(0x02);
+    receiver.setSourceTransport(fromSender, [&](uint8_t* data, size_t len) {
+        std::lock_guard<std::mutex> guard(pipeLock);
+        pipe.insert(pipe.end(), data, data + len);
+        return true;
+    });
+    std::atomic<uint64_t> delivered{0};
+    receiver.registerDispatcher("sink", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+        [&delivered](const char*, const char*, const char*, size_t, EventHeader&) {
+            // Slow consumer: ~20us of work per frame
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+            while (std::chrono::steady_clock::now() < until) {}
+            delivered.fetch_add(1, std::memory_order_relaxed);
+        });
+
+    // The wire accepts every frame; whether the far queue has room is its problem
+    uint64_t queueDrops = 0;
+    EventSourceId fromReceiver = sender.createDirectSource();
+    sender.setAddr(0x01);
+    sender.setSourceTransport(fromReceiver, [&](uint8_t* data, size_t len) {
+        if (!receiverQueues.pushToSource(fromSender, data, len)) queueDrops++;
+        return true;
+    });
+
+    FlowControl flow(receiver, 0x02);
+    FlowControl senderFlow(sender, 0x01);
+    if (flowControl) {
+        flow.begin("flow");
+        senderFlow.begin("flow");
+    }
+
+    const uint64_t total = ctx.minSeconds < 0.1 ? 2000 : 20000;
+    auto payload = bench::makePayload(200, 0.01);
+    EventHeader header{0x01, 0x02, 0x00, 0};
+    std::atomic<bool> done{false};
+    uint64_t accepted = 0;
+    uint64_t refused = 0;
+
+    auto m = ctx.time([&] {
+        std::thread consumer([&] {
+            while (!done.load()) {
+                receiver.processAllSources();
+                if (flowControl) flow.update();
+                std::this_thread::yield();
+            }
+            receiver.processAllSources();
+        });
+
+        std::vector<uint8_t> inbound;
+        while (accepted < total) {
+            {
+                std::lock_guard<std::mutex> guard(pipeLock);
+                inbound.swap(pipe);
+            }
+            if (!inbound.empty()) {
+                sender.process(fromReceiver, inbound.data(), inbound.size());
+                inbound.clear();
+            }
+            if (sender.send("data", payload.data(), payload.size(), header) != 0) {
+                accepted++;
+            } else {
+                refused++;
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+        consumer.join();
+        return delivered.load();
+    });
+
+    if (flowControl) {
+        flow.end();
+        senderFlow.end();
+    }
+    receiver.removeSource(fromSender);
+
+    ctx.report(std::string("flow/overload/") + (flowControl ? "xonxoff" : "none"), {
+        {"delivered_per_sec", m.opsPerSec()},
+        {"loss_ratio", (double)(accepted - m.ops) / accepted},
+        {"queue_drops", (double)queueDrops},
+        {"sends_refused", (double)refused},
+        {"xoff_sent", (double)flow.getStats().xoffSent},
+    });
+}
+
+BENCH_CASE(flow) {
+    runOverload(ctx, false);
+    runOverload(ctx, true);
+}
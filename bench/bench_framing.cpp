@@ -0,0 +1,124 @@
+// Byte stuffing, frame parsing and frame building
+#include "Bench.h"
+#include "EventMsg.h"
+
+#include <string>
+
+static const double densities[] = {0.0, 0.01, 0.10, 0.50};
+
+static std::string densityName(double density) {
+    return std::to_string((int)(density * 100)) + "pct";
+}
+
+BENCH_CASE(stuffing) {
+    const size_t length = 2048;
+    for (double density : densities) {
+        auto input = bench::makePayload(length, density);
+        std::vector<uint8_t> stuffed(length * 2);
+        std::vector<uint8_t> unstuffed(length);
+        size_t stuffedLen = EventMsg::ByteStuff(input.data(), length, stuffed.data(), stuffed.size());
+
+        auto stuff = ctx.measure([&] {
+            EventMsg::ByteStuff(input.data(), length, stuffed.data(), stuffed.size());
+        });
+        ctx.report("stuff/" + densityName(density), {
+            {"MB_per_sec", length * stuff.opsPerSec() / 1e6},
+            {"ns_per_op", stuff.nsPerOp()},
+        });
+
+        auto unstuff = ctx.measure([&] {
+            EventMsg::ByteUnstuff(stuffed.data(), stuffedLen, unstuffed.data(), unstuffed.size());
+        });
+        ctx.report("unstuff/" + densityName(density), {
+            {"MB_per_sec", length * unstuff.opsPerSec() / 1e6},
+            {"ns_per_op", unstuff.nsPerOp()},
+        });
+    }
+}
+
+// Encode `count` frames into one stream, as a peer would send them
+static std::vector<uint8_t> buildStream(EventMsg& encoder, size_t payloadLen, double density,
+                                        uint8_t crc, size_t count) {
+    auto payload = bench::makePayload(payloadLen, density);
+    EventHeader header{0x02, 0x01, 0x00, crc};
+    PSRAMVector<uint8_t> frame;
+    std::vector<uint8_t> stream;
+    for (size_t i = 0; i < count; i++) {
+        size_t len = encoder.encodeFrame("sensor", payload.data(), payload.size(), header,
+                                         encoder.nextMsgId(), frame);
+        stream.insert(stream.end(), frame.begin(), frame.begin() + len);
+    }
+    return stream;
+}
+
+static void runProcess(bench::Context& ctx, const std::string& name, size_t payloadLen,
+                       double density, uint8_t crc) {
+    EventMsg encoder;
+    const size_t count = 64;
+    auto stream = buildStream(encoder, payloadLen, density, crc, count);
+
+    EventMsg node;
+    node.init([](uint8_t*, size_t) { return true; });
+    node.setAddr(0x01);
+    uint64_t frames = 0;
+    node.registerDispatcher("bench", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+        [&frames](const char*, const char*, const char*, size_t, EventHeader&) { frames++; });
+    EventSourceId source = node.createDirectSource();
+
+    // Fed in RawPacket-sized chunks, the way queued sources deliver bytes
+    auto m = ctx.measure([&] {
+        for (size_t pos = 0; pos < stream.size(); pos += RawPacket::MAX_SIZE) {
+            size_t chunk = stream.size() - pos < RawPacket::MAX_SIZE ? stream.size() - pos : RawPacket::MAX_SIZE;
+            node.process(source, stream.data() + pos, chunk);
+        }
+    });
+    double framesPerSec = m.opsPerSec() * count;
+    ctx.report(name, {
+        {"frames_per_sec", framesPerSec},
+        {"MB_per_sec", m.opsPerSec() * stream.size() / 1e6},
+        {"allocs_per_frame", m.allocsPerOp() / count},
+        {"delivered", (double)frames / (m.ops * count)},
+    });
+}
+
+BENCH_CASE(process) {
+    const size_t sizes[] = {16, 128, 1024, 2000};
+    for (size_t size : sizes) {
+        for (double density : densities) {
+            runProcess(ctx, "process/" + std::to_string(size) + "/" + densityName(density), size, density, 0);
+        }
+    }
+    runProcess(ctx, "process/128/1pct/crc16", 128, 0.01, EVENT_FLAG_CRC16);
+    runProcess(ctx, "process/128/1pct/crc32", 128, 0.01, EVENT_FLAG_CRC32);
+    runProcess(ctx, "process/1024/1pct/crc32", 1024, 0.01, EVENT_FLAG_CRC32);
+}
+
+BENCH_CASE(send) {
+    const size_t sizes[] = {16, 128, 1024};
+    EventMsg node;
+    size_t written = 0;
+    node.init([&written](uint8_t*, size_t len) { written += len; return true; });
+    node.setAddr(0x01);
+    EventHeader header{0x01, 0x02, 0x00, 0};
+
+    for (size_t size : sizes) {
+        auto payload = bench::makePayload(size, 0.01);
+        auto m = ctx.measure([&] {
+            node.send("sensor", payload.data(), payload.size(), header);
+        });
+        ctx.report("send/" + std::to_string(size), {
+            {"ns_per_op", m.nsPerOp()},
+            {"allocs_per_op", m.allocsPerOp()},
+        });
+    }
+
+    header.flags = EVENT_FLAG_CRC32;
+    auto payload = bench::makePayload(128, 0.01);
+    auto m = ctx.measure([&] {
+        node.send("sensor", payload.data(), payload.size(), header);
+    });
+    ctx.report("send/128/crc32", {
+        {"ns_per_op", m.nsPerOp()},
+        {"allocs_per_op", m.allocsPerOp()},
+    });
+}
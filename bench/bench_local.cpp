@@ -0,0 +1,111 @@
+// Events between subsystems on one node: a loopback transport against local delivery
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+
+#include <string>
+
+static const size_t sizes[] = {16, 256, 1024};
+
+BENCH_CASE(local) {
+    for (size_t size : sizes) {
+        auto payload = bench::makePayload(size, 0.05, 3);
+
+        for (bool local : {false, true}) {
+            EventMsg node;
+            node.setAddr(0x01);
+            uint64_t written = 0;
+            EventSourceId loop = node.createDirectSource();
+            // The way it is done without local delivery: write the frame
+            // back into our own parser
+            node.setWriteCallback([&](uint8_t* data, size_t len) {
+                written++;
+                return local || node.process(loop, data, len);
+            });
+            node.setLocalDelivery(local);
+
+            EventDispatcher dispatcher(0x01, 0x01);
+            uint64_t hits = 0;
+            dispatcher.on("sensor/temp", [&hits](const char*, size_t, EventHeader&) { hits++; });
+            dispatcher.registerWith(node, "bench");
+
+            const EventHeader toSelf = dispatcher.createHeader(0x01);
+            auto m = ctx.measure([&] {
+                node.send("sensor/temp", payload.data(), payload.size(), toSelf);
+            });
+            PreparedEvent prepared(node, "sensor/temp", toSelf);
+            auto p = ctx.measure([&] {
+                prepared.send(payload.data(), payload.size());
+            });
+
+            ctx.report(std::string("local/") + (local ? "direct/" : "loopback/") + std::to_string(size), {
+                {"ns_per_message", m.nsPerOp()},
+                {"prepared_ns_per_message", p.nsPerOp()},
+                {"allocs_per_message", m.allocsPerOp()},
+                {"delivered", hits == m.ops + p.ops ? 1.0 : 0.0},
+                {"frames_written", (double)written},
+            });
+            node.removeSource(loop);
+        }
+    }
+
+    // A group send: delivered here, and still one frame for the other members
+    {
+        EventMsg node;
+        node.setAddr(0x01);
+        node.setGroup(0x05);
+        node.setLocalDelivery(true);
+        uint64_t written = 0;
+        node.setWriteCallback([&](uint8_t*, size_t) { written++; return true; });
+
+        uint64_t hits = 0;
+        node.registerDispatcher("group", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, 0x05, 0},
+            [&hits](const char*, const char*, const char*, size_t, EventHeader&) { hits++; });
+
+        const char text[] = "23.5";
+        auto m = ctx.measure([&] {
+            node.send("sensor/temp", (const uint8_t*)text, sizeof(text) - 1, EventHeader{0x01, BROADCAST_ADDR, 0x05, 0});
+        });
+        ctx.report("local/group", {
+            {"ns_per_message", m.nsPerOp()},
+            {"delivered", hits == m.ops ? 1.0 : 0.0},
+            {"frames_per_message", (double)written / m.ops},
+        });
+    }
+
+    // A handler that keeps sending to this node: each level reads its own
+    // NUL-terminated copy, and past the depth limit the event goes out framed
+    {
+        EventMsg node;
+        node.setAddr(0x01);
+        node.setLocalDelivery(true);
+        uint64_t written = 0;
+        node.setWriteCallback([&](uint8_t*, size_t) { written++; return true; });
+
+        const EventHeader toSelf{0x01, 0x01, 0x00, 0};
+        const char chain[] = "0123456789";
+        uint64_t hits = 0;
+        bool terminated = true;
+        bool intact = true;
+        node.registerDispatcher("chain", EventHeader{BROADCAST_SENDER, 0x01, BROADCAST_ADDR, 0},
+            [&](const char*, const char*, const char* data, size_t length, EventHeader&) {
+                hits++;
+                if (data[length] != '\0') terminated = false;
+                // Send the rest, one byte shorter, then check ours is untouched
+                if (length > 1) node.send("chain", (const uint8_t*)data + 1, length - 1, toSelf);
+                if (strncmp(data, chain + sizeof(chain) - 1 - length, length) != 0) intact = false;
+            });
+
+        auto m = ctx.measure([&] {
+            node.send("chain", (const uint8_t*)chain, sizeof(chain) - 1, toSelf);
+        });
+        ctx.report("local/nested", {
+            {"ns_per_chain", m.nsPerOp()},
+            {"handled_per_chain", (double)hits / m.ops},
+            {"frames_per_chain", (double)written / m.ops},
+            {"max_depth", (double)MAX_LOCAL_DELIVERY_DEPTH},
+            {"nul_terminated", terminated ? 1.0 : 0.0},
+            {"payload_intact", intact ? 1.0 : 0.0},
+        });
+    }
+}
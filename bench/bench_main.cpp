@@ -0,0 +1,128 @@
+// EventMsg host benchmarks.
+//
+//   eventmsg_bench [--quick] [--filter SUBSTR] [--json FILE|-]
+//
+// Prints a table of results and optionally writes them as JSON so runs
+// can be compared release over release.
+#include "Bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <random>
+
+namespace bench {
+
+std::atomic<uint64_t> allocations{0};
+
+std::vector<std::pair<const char*, CaseFn>>& registry() {
+    static std::vector<std::pair<const char*, CaseFn>> cases;
+    return cases;
+}
+
+Registrar::Registrar(const char* name, CaseFn fn) {
+    registry().emplace_back(name, fn);
+}
+
+void Context::report(const std::string& name, std::vector<Metric> metrics) {
+    printf("  %-44s", name.c_str());
+    for (const auto& metric : metrics) {
+        printf("  %s=%.4g", metric.name.c_str(), metric.value);
+    }
+    printf("\n");
+    fflush(stdout);
+    results.push_back(Result{name, std::move(metrics)});
+}
+
+std::vector<uint8_t> makePayload(size_t length, double density, uint32_t seed) {
+    static const uint8_t controls[] = {0x01, 0x02, 0x04, 0x1B, 0x1F};
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> printable(0x20, 0x7E);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::vector<uint8_t> payload(length);
+    for (auto& byte : payload) {
+        byte = coin(rng) < density ? controls[rng() % sizeof(controls)] : (uint8_t)printable(rng);
+    }
+    return payload;
+}
+
+} // namespace bench
+
+// Count every heap allocation so benchmarks can report allocs/op. The
+// link wraps malloc (CMakeLists.txt), which catches PSRAMAllocator too;
+// operator new is routed through it so libstdc++'s own copy is bypassed.
+extern "C" void* __real_malloc(size_t size);
+
+extern "C" void* __wrap_malloc(size_t size) {
+    bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* operator new(size_t size) {
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static void writeJson(FILE* out, const std::vector<bench::Result>& results) {
+    fprintf(out, "{\n  \"schema\": 1,\n  \"timestamp\": %ld,\n", (long)time(nullptr));
+#ifdef __VERSION__
+    fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(out, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        fprintf(out, "    {\"name\": \"%s\", \"metrics\": {", results[i].name.c_str());
+        for (size_t j = 0; j < results[i].metrics.size(); j++) {
+            fprintf(out, "%s\"%s\": %.6g", j ? ", " : "",
+                    results[i].metrics[j].name.c_str(), results[i].metrics[j].value);
+        }
+        fprintf(out, "}}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    bench::Context ctx;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            ctx.minSeconds = 0.02;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--filter SUBSTR] [--json FILE|-]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (const auto& entry : bench::registry()) {
+        if (filter != nullptr && strstr(entry.first, filter) == nullptr) continue;
+        printf("%s\n", entry.first);
+        entry.second(ctx);
+    }
+
+    if (jsonPath != nullptr) {
+        bool toStdout = strcmp(jsonPath, "-") == 0;
+        FILE* out = toStdout ? stdout : fopen(jsonPath, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(out, ctx.results);
+        if (!toStdout) fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Compact event IDs: bytes per frame and receive CPU, named vs EventNames
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+#include "EventNames.h"
+
+#include <string>
+
+namespace {
+
+// Two nodes joined by byte queues, so a reply sent while parsing is only
+// delivered once the current frame is done
+struct Link {
+    EventMsg a;
+    EventMsg b;
+    EventSourceId aSource = 0;
+    EventSourceId bSource = 0;
+    std::vector<uint8_t> toA;
+    std::vector<uint8_t> toB;
+    uint64_t bytesToB = 0;
+
+    Link() {
+        a.setAddr(0x01);
+        b.setAddr(0x02);
+        aSource = a.createDirectSource();
+        bSource = b.createDirectSource();
+        a.setWriteCallback([this](uint8_t* data, size_t len) {
+            toB.insert(toB.end(), data, data + len);
+            bytesToB += len;
+            return true;
+        });
+        b.setWriteCallback([this](uint8_t* data, size_t len) {
+            toA.insert(toA.end(), data, data + len);
+            return true;
+        });
+    }
+
+    ~Link() {
+        a.removeSource(aSource);
+        b.removeSource(bSource);
+    }
+
+    void pump() {
+        std::vector<uint8_t> chunk;
+        while (!toA.empty() || !toB.empty()) {
+            chunk.swap(toB);
+            toB.clear();
+            b.process(bSource, chunk.data(), chunk.size());
+            chunk.swap(toA);
+            toA.clear();
+            a.process(aSource, chunk.data(), chunk.size());
+        }
+    }
+};
+
+}  // namespace
+
+BENCH_CASE(names) {
+    const char* events[] = {"sensordata", "telemetry/battery/voltage"};
+    const char value[] = "23.5";
+
+    for (const char* event : events) {
+        for (bool compact : {false, true}) {
+            Link link;
+            EventNames namesA(link.a);
+            EventNames namesB(link.b);
+            if (compact) {
+                namesA.begin("names");
+                namesB.begin("names");
+                namesA.compact(event);
+            }
+            EventDispatcher dispatcher;
+            uint64_t handled = 0;
+            dispatcher.registerWith(link.b, "bench");
+            dispatcher.on(event, [&handled](const char*, size_t, EventHeader&) { handled++; });
+
+            EventHeader header{0x01, 0x02, 0x00, 0};
+            // First send carries the definition; steady state from here on
+            link.a.send(event, value, header);
+            link.pump();
+
+            // One frame on the wire, as the receiver sees it
+            link.bytesToB = 0;
+            link.a.send(event, value, header);
+            std::vector<uint8_t> frame = link.toB;
+            double frameBytes = (double)link.bytesToB;
+            link.pump();
+
+            auto send = ctx.measure([&] {
+                link.a.send(event, value, header);
+                link.toB.clear();
+            });
+            auto receive = ctx.measure([&] {
+                link.b.process(link.bSource, frame.data(), frame.size());
+            });
+
+            std::string label = std::string("names/") + (compact ? "compact/" : "named/") + std::to_string(strlen(event));
+            ctx.report(label, {
+                {"bytes_per_frame", frameBytes},
+                {"send_ns", send.nsPerOp()},
+                {"receive_ns", receive.nsPerOp()},
+                {"receive_allocs", receive.allocsPerOp()},
+                {"delivered", handled >= 2 + receive.ops ? 1.0 : 0.0},
+            });
+        }
+    }
+
+    // A receiver that missed the _evdef: frames lost before it asks and heals
+    {
+        Link link;
+        EventNames namesA(link.a);
+        EventNames namesB(link.b);
+        namesA.begin("names");
+        namesA.compact("sensordata");
+        link.a.send("sensordata", value, EventHeader{0x01, 0x02, 0x00, 0});
+        link.toB.clear();  // Definition and first frame lost
+        namesB.begin("names");
+
+        EventDispatcher dispatcher;
+        uint64_t handled = 0;
+        dispatcher.registerWith(link.b, "bench");
+        dispatcher.on("sensordata", [&handled](const char*, size_t, EventHeader&) { handled++; });
+        const size_t sent = 10;
+        for (size_t i = 0; i < sent; i++) {
+            link.a.send("sensordata", value, EventHeader{0x01, 0x02, 0x00, 0});
+            link.pump();
+        }
+        auto stats = namesB.getStats();
+        ctx.report("names/late_join", {
+            {"frames_lost", (double)(sent - handled)},
+            {"requests_sent", (double)stats.requestsSent},
+        });
+    }
+}
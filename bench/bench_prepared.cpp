@@ -0,0 +1,49 @@
+// Repeated sends: send() vs a PreparedEvent with the prefix stuffed once
+#include "Bench.h"
+#include "EventMsg.h"
+
+#include <string>
+
+BENCH_CASE(prepared) {
+    const size_t sizes[] = {0, 8, 64, 512};
+    const char* name = "telemetry/battery";
+
+    for (uint8_t crc : {(uint8_t)0, (uint8_t)EVENT_FLAG_CRC16}) {
+        for (size_t size : sizes) {
+            auto payload = bench::makePayload(size, 0.01);
+            EventMsg node;
+            node.setAddr(0x01);
+            node.setCrcMode(crc);
+            node.setWriteCallback([](uint8_t*, size_t) { return true; });
+            EventHeader header{0x01, 0x02, 0x00, 0};
+            PreparedEvent prepared(node, name, header);
+
+            auto plain = ctx.measure([&] {
+                node.send(name, payload.data(), payload.size(), header);
+            });
+            auto cached = ctx.measure([&] {
+                prepared.send(payload.data(), payload.size());
+            });
+
+            // Byte-for-byte the frame encodeFrame() builds, across msgIds
+            // that need stuffing (0x01xx, 0x1Bxx)
+            PSRAMVector<uint8_t> expected;
+            PSRAMVector<uint8_t> actual;
+            double identical = 1;
+            for (uint32_t msgId = 0; msgId < 0x10000; msgId += 0xFF) {
+                node.encodeFrame(name, payload.data(), payload.size(), header, (uint16_t)msgId, expected);
+                prepared.encode(payload.data(), payload.size(), (uint16_t)msgId, actual);
+                if (expected != actual) identical = 0;
+            }
+
+            std::string label = std::string("prepared/") + (crc ? "crc16/" : "nocrc/") + std::to_string(size);
+            ctx.report(label, {
+                {"send_ns", plain.nsPerOp()},
+                {"prepared_ns", cached.nsPerOp()},
+                {"saved_ns", plain.nsPerOp() - cached.nsPerOp()},
+                {"allocs_per_op", cached.allocsPerOp()},
+                {"identical", identical},
+            });
+        }
+    }
+}
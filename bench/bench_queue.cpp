@@ -0,0 +1,138 @@
+// ThreadSafeQueue and SourceQueueManager under one and two threads
+#include "Bench.h"
+#include "EventMsg.h"
+
+#include <thread>
+
+BENCH_CASE(queue) {
+    uint8_t data[64];
+    memset(data, 0x55, sizeof(data));
+
+    // Uncontended cost of one push + pop
+    {
+        ThreadSafeQueue queue;
+        queue.initialize();
+        RawPacket packet;
+        auto m = ctx.measure([&] {
+            queue.push(data, sizeof(data), 1);
+            queue.tryPop(packet);
+        });
+        ctx.report("queue/push_pop", {
+            {"ns_per_op", m.nsPerOp()},
+            {"allocs_per_op", m.allocsPerOp()},
+        });
+
+        auto isr = ctx.measure([&] {
+            queue.pushFromISR(data, sizeof(data), 1);
+            queue.tryPop(packet);
+        });
+        ctx.report("queue/push_isr_pop", {
+            {"ns_per_op", isr.nsPerOp()},
+            {"allocs_per_op", isr.allocsPerOp()},
+        });
+    }
+
+    // One producer, one consumer; a full queue counts as a drop and the
+    // producer retries, so drops measure how far the consumer lags
+    const size_t payloads[] = {64, 512};
+    for (size_t size : payloads) {
+        ThreadSafeQueue queue;
+        queue.initialize();
+        std::vector<uint8_t> payload(size, 0x55);
+        const uint64_t total = ctx.minSeconds < 0.1 ? 20000 : 200000;
+        uint64_t retries = 0;
+
+        auto m = ctx.time([&] {
+            std::thread consumer([&] {
+                RawPacket packet;
+                uint64_t received = 0;
+                while (received < total) {
+                    if (queue.tryPop(packet)) {
+                        received++;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            for (uint64_t i = 0; i < total; i++) {
+                while (!queue.push(payload.data(), payload.size(), 1)) {
+                    retries++;
+                    std::this_thread::yield();
+                }
+            }
+            consumer.join();
+            return total;
+        });
+        ctx.report("queue/spsc/" + std::to_string(size), {
+            {"ops_per_sec", m.opsPerSec()},
+            {"MB_per_sec", m.opsPerSec() * size / 1e6},
+            {"full_per_op", (double)retries / total},
+        });
+    }
+
+    // Interrupt-style producer waking a consumer blocked on a task notification;
+    // each packet carries its push time so the consumer can measure wake latency
+    {
+        SourceQueueManager manager;
+        EventSourceId source = manager.createSource();
+        const uint64_t total = ctx.minSeconds < 0.1 ? 500 : 5000;
+        std::atomic<TaskHandle_t> consumerTask{nullptr};
+        std::atomic<bool> done{false};
+        uint64_t received = 0;
+        double latencySum = 0;
+        double latencyMax = 0;
+
+        auto m = ctx.time([&] {
+            std::thread consumer([&] {
+                consumerTask = xTaskGetCurrentTaskHandle();
+                while (!done.load() || received < total) {
+                    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+                    manager.processAll([&](EventSourceId, const uint8_t* bytes, size_t) {
+                        int64_t pushedAt;
+                        memcpy(&pushedAt, bytes, sizeof(pushedAt));
+                        double us = (std::chrono::steady_clock::now().time_since_epoch().count() - pushedAt) / 1e3;
+                        latencySum += us;
+                        if (us > latencyMax) latencyMax = us;
+                        received++;
+                    });
+                }
+            });
+            while (consumerTask.load() == nullptr) std::this_thread::yield();
+            manager.setNotifyTask(consumerTask.load());
+
+            for (uint64_t i = 0; i < total; i++) {
+                int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+                while (!manager.pushToSourceFromISR(source, (const uint8_t*)&now, sizeof(now))) {
+                    std::this_thread::yield();
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            done = true;
+            consumer.join();
+            return received;
+        });
+        ctx.report("queue/isr_wake", {
+            {"ops_per_sec", m.opsPerSec()},
+            {"latency_us_mean", received ? latencySum / received : 0},
+            {"latency_us_max", latencyMax},
+        });
+    }
+
+    // Source manager routing on top of the queues
+    {
+        SourceQueueManager manager;
+        EventSourceId sources[16];
+        for (auto& id : sources) id = manager.createSource(512, 8);
+        size_t next = 0;
+        auto m = ctx.measure([&] {
+            manager.pushToSource(sources[next++ & 15], data, sizeof(data));
+            if ((next & 15) == 0) {
+                manager.processAll([](EventSourceId, const uint8_t*, size_t) {});
+            }
+        });
+        ctx.report("queue/sources16", {
+            {"ns_per_op", m.nsPerOp()},
+            {"allocs_per_op", m.allocsPerOp()},
+        });
+    }
+}
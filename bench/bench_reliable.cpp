@@ -0,0 +1,126 @@
+// Reliable channel over a lossy in-process link: throughput, retransmits, ordering
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventReliable.h"
+
+#include <deque>
+#include <string>
+#include <thread>
+
+namespace {
+
+// One direction of the link: frames are queued, not processed inside the
+// sender's write, and a fixed share of them is dropped
+struct LossyLink {
+    std::deque<std::vector<uint8_t>> frames;
+    double loss = 0;
+    uint32_t rng = 0x9E3779B9;
+    uint64_t dropped = 0;
+
+    bool write(const uint8_t* data, size_t len) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        if ((rng % 10000) < loss * 10000) {
+            dropped++;
+            return true;  // Lost on the air, not refused
+        }
+        frames.emplace_back(data, data + len);
+        return true;
+    }
+
+    size_t pump(EventMsg& to, EventSourceId source) {
+        size_t n = 0;
+        while (!frames.empty()) {
+            std::vector<uint8_t> frame;
+            frame.swap(frames.front());
+            frames.pop_front();
+            to.process(source, frame.data(), frame.size());
+            n++;
+        }
+        return n;
+    }
+};
+
+}  // namespace
+
+static const double lossRates[] = {0.0, 0.01, 0.05, 0.10, 0.20};
+
+BENCH_CASE(reliable) {
+    const uint32_t messages = ctx.minSeconds < 0.1 ? 2000 : 20000;
+    const size_t payloadLen = 64;
+
+    for (double loss : lossRates) {
+        EventMsg a;
+        EventMsg b;
+        a.setAddr(0x01);
+        b.setAddr(0x02);
+        LossyLink toB;
+        LossyLink toA;
+        toB.loss = toA.loss = loss;
+        EventSourceId fromA = b.createDirectSource();
+        EventSourceId fromB = a.createDirectSource();
+        a.setWriteCallback([&](uint8_t* data, size_t len) { return toB.write(data, len); });
+        b.setWriteCallback([&](uint8_t* data, size_t len) { return toA.write(data, len); });
+
+        uint32_t received = 0;
+        bool inOrder = true;
+        b.registerDispatcher("sink", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [&](const char*, const char*, const char* data, size_t length, EventHeader&) {
+                uint32_t index = 0;
+                if (length >= sizeof(index)) memcpy(&index, data, sizeof(index));
+                if (index != received) inOrder = false;
+                received++;
+            });
+
+        ReliableChannel::Config config(16, 2, 50);
+        ReliableChannel sender(a, 0x01, 0x02, config);
+        ReliableChannel receiver(b, 0x02, 0x01, config);
+        sender.begin("reliable");
+        receiver.begin("reliable");
+
+        auto payload = bench::makePayload(payloadLen, 0.02, 11);
+        const EventHeader header{0x01, 0x02, 0x00, 0};
+        uint32_t next = 0;
+        bool finished = true;
+        auto m = ctx.time([&] {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+            while (received < messages) {
+                while (next < messages && sender.canSend()) {
+                    memcpy(payload.data(), &next, sizeof(next));
+                    if (sender.send("data", payload.data(), payload.size(), header) == 0) break;
+                    next++;
+                }
+                size_t moved = toB.pump(b, fromA) + toA.pump(a, fromB);
+                sender.update();
+                receiver.update();
+                if (moved == 0) {
+                    // Only timers can make progress; they tick in milliseconds
+                    if (std::chrono::steady_clock::now() > deadline) {
+                        finished = false;
+                        break;
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+            return (uint64_t)received;
+        });
+
+        const ReliableChannel::Stats& tx = sender.getStats();
+        const ReliableChannel::Stats& rx = receiver.getStats();
+        ctx.report("reliable/loss_" + std::to_string((int)(loss * 100)) + "pct", {
+            {"msgs_per_sec", m.opsPerSec()},
+            {"KB_per_sec", m.opsPerSec() * payloadLen / 1024},
+            {"retransmits_per_msg", (double)tx.retransmits / messages},
+            {"frames_dropped", (double)(toA.dropped + toB.dropped)},
+            {"nacks", (double)rx.nacksSent},
+            {"duplicates", (double)rx.duplicates},
+            {"in_order", inOrder && finished && received == messages ? 1.0 : 0.0},
+        });
+
+        receiver.end();
+        sender.end();
+        a.removeSource(fromB);
+        b.removeSource(fromA);
+    }
+}
@@ -0,0 +1,158 @@
+// RPC client: pipelining, out-of-order responses, timeouts and stray responses
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventRpc.h"
+
+#include <deque>
+#include <thread>
+
+namespace {
+
+struct Link {
+    std::deque<std::vector<uint8_t>> frames;
+
+    bool write(const uint8_t* data, size_t len) {
+        frames.emplace_back(data, data + len);
+        return true;
+    }
+
+    void pump(EventMsg& to, EventSourceId source) {
+        while (!frames.empty()) {
+            std::vector<uint8_t> frame;
+            frame.swap(frames.front());
+            frames.pop_front();
+            to.process(source, frame.data(), frame.size());
+        }
+    }
+};
+
+struct Request {
+    uint16_t msgId;
+    uint32_t value;
+};
+
+}  // namespace
+
+BENCH_CASE(rpc) {
+    EventMsg client;
+    EventMsg server;
+    client.setAddr(0x01);
+    server.setAddr(0x02);
+    Link toServer;
+    Link toClient;
+    EventSourceId fromClient = server.createDirectSource();
+    EventSourceId fromServer = client.createDirectSource();
+    client.setWriteCallback([&](uint8_t* data, size_t len) { return toServer.write(data, len); });
+    server.setWriteCallback([&](uint8_t* data, size_t len) { return toClient.write(data, len); });
+
+    // The server collects requests and answers them in reverse order
+    std::vector<Request> requests;
+    server.registerDispatcher("server", EventHeader{BROADCAST_SENDER, 0x02, BROADCAST_ADDR, 0},
+        [&](const char*, const char* eventName, const char* data, size_t length, EventHeader& header) {
+            if (strcmp(eventName, "echo") != 0 || length != sizeof(uint32_t)) return;
+            Request request;
+            request.msgId = header.msgId;
+            memcpy(&request.value, data, sizeof(request.value));
+            requests.push_back(request);
+        });
+    auto answerAll = [&] {
+        for (size_t i = requests.size(); i-- > 0;) {
+            EventHeader reply{0x02, 0x01, 0x00, EVENT_FLAG_RESPONSE, requests[i].msgId};
+            server.send("echo", (const uint8_t*)&requests[i].value, sizeof(uint32_t), reply);
+        }
+    };
+
+    // Responses nobody is waiting for reach the client's handlers
+    uint64_t strays = 0;
+    client.registerDispatcher("client", EventHeader{BROADCAST_SENDER, 0x01, BROADCAST_ADDR, 0},
+        [&](const char*, const char*, const char*, size_t, EventHeader& header) {
+            if (header.flags & EVENT_FLAG_RESPONSE) strays++;
+        });
+
+    const size_t window = 16;
+    RpcClient rpc(client, window);
+    rpc.begin("rpc");
+    const EventHeader toPeer{0x01, 0x02, 0x00, 0};
+
+    // Pipelined: a full table of calls in flight, answered last-first
+    {
+        uint64_t matched = 0;
+        uint64_t mismatched = 0;
+        uint32_t value = 0;
+        auto m = ctx.time([&] {
+            const uint64_t rounds = ctx.minSeconds < 0.1 ? 2000 : 20000;
+            for (uint64_t r = 0; r < rounds; r++) {
+                for (size_t i = 0; i < window; i++) {
+                    uint32_t expected = value++;
+                    rpc.call("echo", (const uint8_t*)&expected, sizeof(expected), toPeer, 1000,
+                        [&, expected](RpcStatus status, const char* data, size_t length, EventHeader&) {
+                            uint32_t got = 0;
+                            if (length == sizeof(got)) memcpy(&got, data, sizeof(got));
+                            if (status == RpcStatus::OK && got == expected) {
+                                matched++;
+                            } else {
+                                mismatched++;
+                            }
+                        });
+                }
+                toServer.pump(server, fromClient);
+                answerAll();
+                requests.clear();
+                toClient.pump(client, fromServer);
+            }
+            return rounds * window;
+        });
+        ctx.report("rpc/pipelined_out_of_order", {
+            {"ns_per_call", m.nsPerOp()},
+            {"in_flight", (double)window},
+            {"matched", (double)matched / m.ops},
+            {"mismatched", (double)mismatched},
+            {"left_pending", (double)rpc.pending()},
+        });
+    }
+
+    // Timeouts: the server never answers; update() expires every call
+    {
+        uint64_t timeouts = 0;
+        for (size_t i = 0; i < window; i++) {
+            rpc.call("ignored", "x", toPeer, 5, [&](RpcStatus status, const char*, size_t, EventHeader&) {
+                if (status == RpcStatus::TIMEOUT) timeouts++;
+            });
+        }
+        toServer.pump(server, fromClient);
+        rpc.update();
+        size_t pendingEarly = rpc.pending();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        rpc.update();
+        ctx.report("rpc/timeouts", {
+            {"pending_before_deadline", (double)pendingEarly},
+            {"timed_out", (double)timeouts},
+            {"left_pending", (double)rpc.pending()},
+        });
+    }
+
+    // Duplicate response: the first completes the call, the copy falls
+    // through to normal dispatch
+    {
+        uint64_t completions = 0;
+        strays = 0;
+        uint32_t value = 42;
+        rpc.call("echo", (const uint8_t*)&value, sizeof(value), toPeer, 1000,
+            [&](RpcStatus status, const char*, size_t, EventHeader&) {
+                if (status == RpcStatus::OK) completions++;
+            });
+        toServer.pump(server, fromClient);
+        answerAll();
+        answerAll();
+        requests.clear();
+        toClient.pump(client, fromServer);
+        ctx.report("rpc/duplicate_response", {
+            {"completions", (double)completions},
+            {"dispatched_normally", (double)strays},
+        });
+    }
+
+    rpc.end();
+    client.removeSource(fromServer);
+    server.removeSource(fromClient);
+}
@@ -0,0 +1,62 @@
+// send() from N threads into one transport
+#include "Bench.h"
+#include "EventMsg.h"
+
+#include <string>
+#include <thread>
+
+BENCH_CASE(send_concurrent) {
+    const size_t threadCounts[] = {1, 2, 4, 8};
+    // Stay under 65536 so every msgId in a run should be distinct
+    const size_t total = ctx.minSeconds < 0.1 ? 8000 : 48000;
+    auto payload = bench::makePayload(64, 0.01);
+
+    for (size_t threads : threadCounts) {
+        EventMsg node;
+        node.setAddr(0x01);
+        // The transport is only ever entered under EventMsg's transmit lock,
+        // so it appends without a lock of its own
+        std::vector<uint8_t> wire;
+        wire.reserve(total * 128);
+        node.setWriteCallback([&wire](uint8_t* data, size_t len) {
+            wire.insert(wire.end(), data, data + len);
+            return true;
+        });
+
+        auto m = ctx.time([&] {
+            std::vector<std::thread> senders;
+            for (size_t t = 0; t < threads; t++) {
+                senders.emplace_back([&, t] {
+                    EventHeader header{0x01, 0x02, 0x00, 0};
+                    for (size_t i = t; i < total; i += threads) {
+                        node.send("sensor", payload.data(), payload.size(), header);
+                    }
+                });
+            }
+            for (auto& sender : senders) sender.join();
+            return (uint64_t)total;
+        });
+
+        // Every frame must parse back intact with its own msgId
+        EventMsg checker;
+        std::vector<uint8_t> seen(65536, 0);
+        size_t parsed = 0;
+        size_t duplicates = 0;
+        checker.registerDispatcher("check", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [&](const char*, const char*, const char*, size_t, EventHeader& header) {
+                parsed++;
+                if (seen[header.msgId]++) duplicates++;
+            });
+        EventSourceId source = checker.createDirectSource();
+        checker.process(source, wire.data(), wire.size());
+        checker.removeSource(source);
+
+        ctx.report("send_concurrent/" + std::to_string(threads), {
+            {"frames_per_sec", m.opsPerSec()},
+            {"ns_per_op", m.nsPerOp()},
+            {"allocs_per_op", m.allocsPerOp()},
+            {"intact", (double)parsed / total},
+            {"duplicate_ids", (double)duplicates},
+        });
+    }
+}
@@ -0,0 +1,107 @@
+// Independent EventMsg stacks on N threads, each with its own source manager
+#include "Bench.h"
+#include "EventMsg.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+struct Shard {
+    std::unique_ptr<SourceQueueManager> queues;
+    std::unique_ptr<EventMsg> node;
+    EventSourceId source = 0;
+    std::vector<uint8_t> stream;
+    std::atomic<uint64_t> own{0};     // Frames from this shard's producer
+    std::atomic<uint64_t> stolen{0};  // Frames another shard's producer pushed
+};
+
+static void runShards(bench::Context& ctx, size_t shardCount, double* baseline) {
+    const size_t framesPerShard = ctx.minSeconds < 0.1 ? 2000 : 20000;
+    const size_t framesPerStream = 64;
+    const EventHeader listen{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0};
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    for (size_t s = 0; s < shardCount; s++) {
+        std::unique_ptr<Shard> shard(new Shard());
+        shard->queues.reset(new SourceQueueManager());
+        shard->node.reset(new EventMsg(*shard->queues));
+        Shard* self = shard.get();
+        uint8_t id = (uint8_t)s;
+        shard->node->registerDispatcher("bench", listen,
+            [self, id](const char*, const char*, const char* data, size_t, EventHeader&) {
+                ((uint8_t)data[0] == id ? self->own : self->stolen)++;
+            });
+        shard->source = shard->node->createSource(512, 8);
+
+        // Payload starts with the shard index so a stolen frame can be told apart
+        auto payload = bench::makePayload(64, 0.0, (uint32_t)s + 1);
+        payload[0] = id;
+        EventMsg encoder;
+        PSRAMVector<uint8_t> frame;
+        EventHeader header{0x02, 0x01, 0x00, 0};
+        for (size_t i = 0; i < framesPerStream; i++) {
+            size_t len = encoder.encodeFrame("sensor", payload.data(), payload.size(), header,
+                                             encoder.nextMsgId(), frame);
+            shard->stream.insert(shard->stream.end(), frame.begin(), frame.begin() + len);
+        }
+        shards.push_back(std::move(shard));
+    }
+
+    auto m = ctx.time([&] {
+        std::atomic<size_t> producing{shardCount};
+        std::vector<std::thread> threads;
+        for (auto& shard : shards) {
+            Shard* self = shard.get();
+            threads.emplace_back([&, self] {
+                SourceQueueManager& queues = *self->queues;
+                const std::vector<uint8_t>& stream = self->stream;
+                for (size_t sent = 0; sent < framesPerShard; sent += framesPerStream) {
+                    for (size_t pos = 0; pos < stream.size();) {
+                        size_t chunk = stream.size() - pos < RawPacket::MAX_SIZE ? stream.size() - pos : RawPacket::MAX_SIZE;
+                        if (queues.pushToSource(self->source, stream.data() + pos, chunk)) {
+                            pos += chunk;
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+                producing--;
+            });
+            threads.emplace_back([&, self] {
+                while (producing.load() > 0) {
+                    self->node->processAllSources();
+                    std::this_thread::yield();
+                }
+                self->node->processAllSources();
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        return (uint64_t)(shardCount * ((framesPerShard + framesPerStream - 1) / framesPerStream) * framesPerStream);
+    });
+
+    uint64_t own = 0;
+    uint64_t stolen = 0;
+    for (auto& shard : shards) {
+        own += shard->own.load();
+        stolen += shard->stolen.load();
+        shard->node->removeSource(shard->source);
+    }
+    if (shardCount == 1) *baseline = m.opsPerSec();
+
+    ctx.report("shard/" + std::to_string(shardCount), {
+        {"frames_per_sec", m.opsPerSec()},
+        {"scaling", *baseline > 0 ? m.opsPerSec() / *baseline : 0},
+        {"delivered", (double)own / m.ops},
+        {"stolen", (double)stolen / m.ops},
+    });
+}
+
+BENCH_CASE(shard) {
+    // Scaling is bounded by the cores available; the stubs map tasks to threads
+    double baseline = 0;
+    for (size_t shards : {1, 2, 4}) {
+        runShards(ctx, shards, &baseline);
+    }
+    ctx.report("shard/cores", {{"hardware_threads", (double)std::thread::hardware_concurrency()}});
+}
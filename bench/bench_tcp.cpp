@@ -0,0 +1,207 @@
+// TCP server and client over loopback: replies, broadcasts, slot reuse,
+// refusal over capacity and connects against a running reactor
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventTcp.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#if EVENT_TCP_HOST
+
+namespace {
+
+template <typename Pred>
+bool waitFor(Pred pred, int timeoutMs = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+const size_t capacity = 4;
+const uint8_t serverAddr = 0x01;
+const uint8_t firstClientAddr = 0x10;
+
+}  // namespace
+
+BENCH_CASE(tcp) {
+    // Server: answers every ping with a pong to its sender, which the
+    // learned route sends back down the connection the ping came in on.
+    // Each side has its own source queues: two reactors, two stacks.
+    SourceQueueManager serverQueues;
+    EventMsg server(serverQueues);
+    server.setAddr(serverAddr);
+    FdTransport serverFds(server);
+    server.registerDispatcher("server", EventHeader{BROADCAST_SENDER, serverAddr, BROADCAST_ADDR, 0},
+        [&](const char*, const char* eventName, const char* data, size_t length, EventHeader& header) {
+            if (strcmp(eventName, "ping") != 0) return;
+            server.send("pong", (const uint8_t*)data, length, EventHeader{serverAddr, header.senderId, 0x00, 0});
+        });
+    TcpServer tcp(serverFds, 0, capacity);
+    if (!tcp.begin() || !serverFds.start()) {
+        ctx.report("tcp/setup", {{"listening", 0}});
+        return;
+    }
+
+    // Clients: one node, one reactor, a connection per simulated device.
+    // Client i sends as firstClientAddr + i; the filter records which
+    // connection each frame arrived on.
+    SourceQueueManager clientQueues;
+    EventMsg node(clientQueues);
+    FdTransport clientFds(node);
+    clientFds.start();
+    std::atomic<EventSourceId> sources[capacity + 1];
+    std::atomic<uint32_t> pongs[capacity + 1];
+    std::atomic<uint32_t> misrouted{0};
+    std::atomic<uint32_t> news[capacity + 1];
+    for (size_t i = 0; i <= capacity; i++) {
+        sources[i] = 0;
+        pongs[i] = 0;
+        news[i] = 0;
+    }
+    node.registerReceiveFilter("tcp", [&](EventSourceId sourceId, const char* eventName, const uint8_t*, size_t, EventHeader& header) {
+        for (size_t i = 0; i <= capacity; i++) {
+            if (sources[i] != sourceId) continue;
+            if (strcmp(eventName, "news") == 0) {
+                news[i]++;
+            } else if (header.receiverId == firstClientAddr + i) {
+                pongs[i]++;
+            } else {
+                misrouted++;
+            }
+            break;
+        }
+        return false;
+    });
+
+    std::unique_ptr<TcpClient> clients[capacity + 1];
+    auto connect = [&](size_t i) {
+        clients[i].reset(new TcpClient(clientFds));
+        if (!clients[i]->connect("127.0.0.1", tcp.getPort())) return false;
+        sources[i] = clients[i]->getSourceId();
+        return true;
+    };
+    auto ping = [&](size_t i, uint32_t seq) {
+        PSRAMVector<uint8_t> frame;
+        EventHeader header{(uint8_t)(firstClientAddr + i), serverAddr, 0x00, 0};
+        size_t len = node.encodeFrame("ping", (const uint8_t*)&seq, sizeof(seq), header, (uint16_t)seq, frame);
+        return node.writeFrameTo(sources[i], frame.data(), len);
+    };
+
+    bool connected = true;
+    for (size_t i = 0; i < capacity; i++) connected = connect(i) && connected;
+    connected = connected && waitFor([&] { return tcp.clientCount() == capacity; });
+
+    // Pings from every client at once; each pong must come back on the
+    // connection that sent the ping
+    {
+        const uint32_t perClient = ctx.minSeconds < 0.1 ? 200 : 2000;
+        auto m = ctx.time([&] {
+            for (uint32_t seq = 0; seq < perClient; seq++) {
+                for (size_t i = 0; i < capacity; i++) ping(i, seq);
+            }
+            waitFor([&] {
+                for (size_t i = 0; i < capacity; i++) {
+                    if (pongs[i] < perClient) return false;
+                }
+                return true;
+            });
+            uint64_t answered = 0;
+            for (size_t i = 0; i < capacity; i++) answered += pongs[i];
+            return answered;
+        });
+        ctx.report("tcp/ping", {
+            {"us_per_ping", m.nsPerOp() / 1000},
+            {"connected", connected ? 1.0 : 0.0},
+            {"answered", (double)m.ops / (perClient * capacity)},
+            {"misrouted", (double)misrouted},
+        });
+    }
+
+    // One broadcast from the server: a copy per client
+    {
+        const uint32_t count = 100;
+        for (uint32_t i = 0; i < count; i++) {
+            server.send("news", "update", EventHeader{serverAddr, BROADCAST_ADDR, 0x00, 0});
+        }
+        bool all = waitFor([&] {
+            for (size_t i = 0; i < capacity; i++) {
+                if (news[i] < count) return false;
+            }
+            return true;
+        });
+        uint32_t fewest = count;
+        for (size_t i = 0; i < capacity; i++) {
+            if (news[i] < fewest) fewest = news[i];
+        }
+        ctx.report("tcp/broadcast", {
+            {"reached_every_client", all ? 1.0 : 0.0},
+            {"fewest_received", (double)fewest},
+        });
+    }
+
+    // Full: one more client is accepted by the kernel, then refused by the
+    // server, which closes it
+    {
+        bool started = connect(capacity);
+        bool dropped = started && waitFor([&] { return !clients[capacity]->isConnected(); });
+        ctx.report("tcp/over_capacity", {
+            {"refused", dropped && tcp.getStats().rejected == 1 ? 1.0 : 0.0},
+            {"clients", (double)tcp.clientCount()},
+        });
+        clients[capacity].reset();
+    }
+
+    // A client leaves; its slot takes the next connection, which is
+    // answered like the others
+    {
+        clients[0]->disconnect();
+        bool freed = waitFor([&] { return !clients[0]->isConnected() && tcp.clientCount() == capacity - 1; });
+        uint32_t rejected = tcp.getStats().rejected;
+        pongs[0] = 0;
+        bool reused = connect(0) && waitFor([&] { return tcp.clientCount() == capacity; });
+        reused = reused && ping(0, 1) && waitFor([&] { return pongs[0] == 1; });
+        ctx.report("tcp/slot_reuse", {
+            {"freed", freed ? 1.0 : 0.0},
+            {"reused", reused && tcp.getStats().rejected == rejected ? 1.0 : 0.0},
+        });
+    }
+
+    // Connect and disconnect against both running reactors, from this thread
+    {
+        clients[capacity - 1]->disconnect();
+        waitFor([&] { return tcp.clientCount() == capacity - 1; });
+        const size_t rounds = ctx.minSeconds < 0.1 ? 50 : 500;
+        uint32_t acceptedBefore = tcp.getStats().accepted;
+        size_t cycles = 0;
+        auto m = ctx.time([&] {
+            for (size_t r = 0; r < rounds; r++) {
+                TcpClient client(clientFds);
+                if (!client.connect("127.0.0.1", tcp.getPort())) break;
+                client.disconnect();
+                if (!waitFor([&] { return !client.isConnected(); })) break;
+                cycles++;
+            }
+            return (uint64_t)rounds;
+        });
+        bool settled = waitFor([&] { return tcp.clientCount() == capacity - 1; });
+        ctx.report("tcp/connect_cycle", {
+            {"us_per_cycle", m.nsPerOp() / 1000},
+            {"completed", (double)cycles / rounds},
+            {"accepted", (double)(tcp.getStats().accepted - acceptedBefore) / rounds},
+            {"slots_settled", settled ? 1.0 : 0.0},
+        });
+    }
+
+    for (auto& client : clients) client.reset();
+    clientFds.end();
+    tcp.end();
+    serverFds.end();
+}
+
+#endif // EVENT_TCP_HOST
@@ -0,0 +1,60 @@
+// Wildcard topic subscriptions: trie match vs a linear catch-all scan
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+
+#include <string.h>
+#include <string>
+
+static const size_t counts[] = {10, 100, 1000};
+
+BENCH_CASE(topic) {
+    const char payload[] = "23.5";
+
+    for (size_t count : counts) {
+        EventDispatcher dispatcher;
+        uint64_t hits = 0;
+        // Half one-level wildcards, half prefix subscriptions, on distinct devices
+        std::vector<std::string> prefixes;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            std::string device = "dev" + std::to_string(i);
+            std::string pattern = device + (i % 2 ? "/sensor/*" : "/#");
+            dispatcher.on(pattern.c_str(), [&hits](const char*, size_t, EventHeader&) { hits++; });
+            prefixes.push_back(device + "/");
+        }
+        double registerUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        // The last device registered: worst case for the linear scan
+        std::string hit = "dev" + std::to_string(count - 1) + "/sensor/temp";
+        const char* miss = "gateway/status/uptime";
+
+        auto trieHit = ctx.measure([&] {
+            EventHeader header{0x02, BROADCAST_ADDR, 0x00, 0};
+            dispatcher.dispatchEvent(hit.c_str(), payload, sizeof(payload) - 1, header);
+        });
+        auto trieMiss = ctx.measure([&] {
+            EventHeader header{0x02, BROADCAST_ADDR, 0x00, 0};
+            dispatcher.dispatchEvent(miss, payload, sizeof(payload) - 1, header);
+        });
+
+        // What a setUnhandledHandler catch-all had to do before: compare
+        // every subscription's prefix against every unmatched frame
+        auto linear = ctx.measure([&] {
+            for (const auto& prefix : prefixes) {
+                if (strncmp(hit.c_str(), prefix.c_str(), prefix.size()) == 0) {
+                    hits++;
+                    break;
+                }
+            }
+        });
+
+        ctx.report("topic/" + std::to_string(count), {
+            {"hit_ns", trieHit.nsPerOp()},
+            {"miss_ns", trieMiss.nsPerOp()},
+            {"linear_scan_ns", linear.nsPerOp()},
+            {"allocs_per_op", trieHit.allocsPerOp()},
+            {"register_us_per_sub", registerUs / count},
+        });
+    }
+}
@@ -0,0 +1,239 @@
+// Gateway forwarding, capture replay and the epoll transport
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventForwarder.h"
+#include "EventCapture.h"
+#include "EventFdTransport.h"
+
+#include <string>
+#include <thread>
+
+#ifdef EVENT_FD_TRANSPORT_AVAILABLE
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static std::vector<uint8_t> encodeOne(size_t payloadLen, const EventHeader& header) {
+    EventMsg encoder;
+    auto payload = bench::makePayload(payloadLen, 0.01);
+    PSRAMVector<uint8_t> frame;
+    size_t len = encoder.encodeFrame("sensor", payload.data(), payload.size(), header, 1, frame);
+    return std::vector<uint8_t>(frame.begin(), frame.begin() + len);
+}
+
+// Forwarding a unicast frame between two ports vs parsing it in full
+BENCH_CASE(forward) {
+    const size_t sizes[] = {16, 256, 1500};
+    for (size_t size : sizes) {
+        EventMsg gateway;
+        gateway.init([](uint8_t*, size_t) { return true; });
+        gateway.setAddr(0x10);
+        gateway.registerDispatcher("local", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [](const char*, const char*, const char*, size_t, EventHeader&) {});
+        EventSourceId portA = gateway.createDirectSource();
+        EventSourceId portB = gateway.createDirectSource();
+        gateway.setSourceTransport(portA, [](uint8_t*, size_t) { return true; });
+        gateway.setSourceTransport(portB, [](uint8_t*, size_t) { return true; });
+        gateway.learnRoute(0x22, portB);
+
+        EventForwarder forwarder(gateway);
+        forwarder.addPort(portA);
+        forwarder.addPort(portB);
+
+        auto frame = encodeOne(size, EventHeader{0x21, 0x22, 0x00, EVENT_FLAG_CRC16});
+        auto forward = ctx.measure([&] {
+            forwarder.process(portA, frame.data(), frame.size());
+        });
+        auto parse = ctx.measure([&] {
+            gateway.process(portA, frame.data(), frame.size());
+        });
+        ctx.report("forward/" + std::to_string(size), {
+            {"forward_ns_per_frame", forward.nsPerOp()},
+            {"parse_ns_per_frame", parse.nsPerOp()},
+            {"forward_allocs_per_frame", forward.allocsPerOp()},
+        });
+    }
+
+    // Rules added while a frame is half-way through: the rules vector grows
+    // under the decision already taken for it
+    {
+        EventMsg gateway;
+        gateway.init([](uint8_t*, size_t) { return true; });
+        gateway.setAddr(0x10);
+        EventSourceId portA = gateway.createDirectSource();
+        EventSourceId portB = gateway.createDirectSource();
+        EventSourceId portC = gateway.createDirectSource();
+        uint64_t toB = 0;
+        uint64_t toC = 0;
+        gateway.setSourceTransport(portA, [](uint8_t*, size_t) { return true; });
+        gateway.setSourceTransport(portB, [&](uint8_t*, size_t) { toB++; return true; });
+        gateway.setSourceTransport(portC, [&](uint8_t*, size_t) { toC++; return true; });
+
+        EventForwarder forwarder(gateway);
+        forwarder.addPort(portA);
+        forwarder.addPort(portB);
+        forwarder.addPort(portC);
+
+        auto frame = encodeOne(256, EventHeader{0x21, 0x22, 0x00, 0});
+        const size_t rounds = 100;
+        for (size_t r = 0; r < rounds; r++) {
+            forwarder.clearRules();
+            ForwardRule rule;
+            rule.receiverId = 0x22;
+            rule.egress.push_back(portB);
+            forwarder.addRule(rule);
+            size_t half = frame.size() / 2;
+            forwarder.process(portA, frame.data(), half);
+            ForwardRule other;
+            other.receiverId = 0x33;
+            other.egress.push_back(portC);
+            for (int i = 0; i < 16; i++) forwarder.addRule(other);
+            forwarder.process(portA, frame.data() + half, frame.size() - half);
+        }
+        ctx.report("forward/rules_changed_mid_frame", {
+            {"to_rule_egress", (double)toB / rounds},
+            {"elsewhere", (double)toC},
+        });
+    }
+}
+
+// Unpaced replay of an in-memory capture
+BENCH_CASE(replay) {
+    EventMsg node;
+    node.init([](uint8_t*, size_t) { return true; });
+    node.setAddr(0x01);
+    node.registerDispatcher("bench", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+        [](const char*, const char*, const char*, size_t, EventHeader&) {});
+    EventSourceId source = node.createDirectSource();
+
+    EventCapture capture(4 * 1024 * 1024);
+    capture.attach(node);
+    auto frame = encodeOne(128, EventHeader{0x02, 0x01, 0x00, 0});
+    const size_t records = 2000;
+    for (size_t i = 0; i < records; i++) {
+        node.process(source, frame.data(), frame.size());
+    }
+    capture.detach(node);
+    PSRAMVector<uint8_t> log;
+    capture.snapshot(log);
+
+    EventReplay replay(node);
+    replay.load(log.data(), log.size());
+    auto m = ctx.measure([&] {
+        replay.rewind();
+        replay.run();
+    });
+    ctx.report("replay/128", {
+        {"frames_per_sec", m.opsPerSec() * records},
+        {"MB_per_sec", m.opsPerSec() * (log.size() - CAPTURE_FILE_HEADER) / 1e6},
+    });
+}
+
+#ifdef EVENT_FD_TRANSPORT_AVAILABLE
+// Aggregate receive rate of one reactor over N socketpairs fed by 4 writers
+BENCH_CASE(fd_transport) {
+    const size_t fdCounts[] = {1, 16, 256};
+    const size_t writers = 4;
+    const size_t framesPerBatch = 50;
+    auto frame = encodeOne(64, EventHeader{0x02, 0x01, 0x00, 0});
+    std::vector<uint8_t> batch;
+    for (size_t i = 0; i < framesPerBatch; i++) {
+        batch.insert(batch.end(), frame.begin(), frame.end());
+    }
+
+    for (size_t fdCount : fdCounts) {
+        EventMsg node;
+        node.init([](uint8_t*, size_t) { return true; });
+        node.setAddr(0x01);
+        std::atomic<uint64_t> frames{0};
+        node.registerDispatcher("bench", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [&frames](const char*, const char*, const char*, size_t, EventHeader&) {
+                frames.fetch_add(1, std::memory_order_relaxed);
+            });
+
+        FdTransport transport(node);
+        std::vector<int> peers;
+        for (size_t i = 0; i < fdCount; i++) {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) break;
+            transport.addFd(sv[0]);
+            peers.push_back(sv[1]);
+        }
+        transport.start();
+
+        const uint64_t totalBatches = ctx.minSeconds < 0.1 ? 2000 : 20000;
+        const uint64_t expected = totalBatches * framesPerBatch;
+        auto m = ctx.time([&] {
+            std::vector<std::thread> threads;
+            for (size_t w = 0; w < writers; w++) {
+                threads.emplace_back([&, w] {
+                    for (uint64_t b = w; b < totalBatches; b += writers) {
+                        int fd = peers[b % peers.size()];
+                        size_t off = 0;
+                        while (off < batch.size()) {
+                            ssize_t n = write(fd, batch.data() + off, batch.size() - off);
+                            if (n > 0) off += n;
+                        }
+                    }
+                });
+            }
+            for (auto& t : threads) t.join();
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+            while (frames.load() < expected && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            return frames.load();
+        });
+
+        transport.end();
+        for (int fd : peers) close(fd);
+        ctx.report("fd_transport/" + std::to_string(peers.size()), {
+            {"frames_per_sec", m.opsPerSec()},
+            {"MB_per_sec", m.opsPerSec() * frame.size() / 1e6},
+            {"delivered", (double)m.ops / expected},
+        });
+    }
+
+    // removeFd() from this thread while the reactor is parsing those fds
+    {
+        EventMsg node;
+        node.init([](uint8_t*, size_t) { return true; });
+        std::atomic<uint64_t> frames{0};
+        node.registerDispatcher("bench", EventHeader{BROADCAST_SENDER, BROADCAST_ADDR, BROADCAST_ADDR, 0},
+            [&frames](const char*, const char*, const char*, size_t, EventHeader&) {
+                frames.fetch_add(1, std::memory_order_relaxed);
+            });
+
+        FdTransport transport(node);
+        transport.start();
+        const size_t rounds = ctx.minSeconds < 0.1 ? 50 : 500;
+        size_t removed = 0;
+        auto m = ctx.time([&] {
+            for (size_t r = 0; r < rounds; r++) {
+                int sv[2];
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) break;
+                EventSourceId id = transport.addFd(sv[0]);
+                std::atomic<bool> stop{false};
+                std::thread writer([&] {
+                    while (!stop.load()) {
+                        // Fails once removeFd() has closed the other end
+                        if (send(sv[1], batch.data(), batch.size(), MSG_NOSIGNAL) < 0) break;
+                    }
+                });
+                while (frames.load() == 0) std::this_thread::yield();
+                if (transport.removeFd(id)) removed++;
+                stop = true;
+                writer.join();
+                close(sv[1]);
+            }
+            return (uint64_t)rounds;
+        });
+        transport.end();
+        ctx.report("fd_transport/remove_live", {
+            {"us_per_remove", m.nsPerOp() / 1000},
+            {"removed", (double)removed / rounds},
+            {"fds_left", (double)transport.getFdCount()},
+        });
+    }
+}
+#endif
@@ -0,0 +1,132 @@
+// Numeric telemetry: text payloads (snprintf/strtof) vs a typed struct
+#include "Bench.h"
+#include "EventMsg.h"
+#include "EventDispatcher.h"
+#include "EventTyped.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+struct EVENT_PACKED Telemetry {
+    float temperature;
+    float humidity;
+    uint16_t batteryMv;
+    int8_t rssi;
+    uint32_t uptime;
+};
+
+Telemetry sample(uint32_t i) {
+    Telemetry t;
+    t.temperature = 20.0f + (float)(i % 100) / 10;
+    t.humidity = 40.0f + (float)(i % 50) / 5;
+    t.batteryMv = (uint16_t)(3700 + i % 500);
+    t.rssi = (int8_t)(-40 - (int)(i % 50));
+    t.uptime = 86400 + i;
+    return t;
+}
+
+int formatText(const Telemetry& t, char* out, size_t size) {
+    return snprintf(out, size, "%.1f,%.1f,%u,%d,%u", t.temperature, t.humidity,
+                    (unsigned)t.batteryMv, (int)t.rssi, (unsigned)t.uptime);
+}
+
+bool parseText(const char* data, Telemetry& t) {
+    char* end;
+    t.temperature = strtof(data, &end);
+    if (*end != ',') return false;
+    t.humidity = strtof(end + 1, &end);
+    if (*end != ',') return false;
+    t.batteryMv = (uint16_t)strtoul(end + 1, &end, 10);
+    if (*end != ',') return false;
+    t.rssi = (int8_t)strtol(end + 1, &end, 10);
+    if (*end != ',') return false;
+    t.uptime = (uint32_t)strtoul(end + 1, &end, 10);
+    return true;
+}
+
+}  // namespace
+
+BENCH_CASE(typed) {
+    const EventHeader header{0x01, 0x02, 0x00, 0};
+
+    // Encode and decode alone
+    {
+        char text[64];
+        uint32_t i = 0;
+        volatile float sink = 0;
+        auto textEncode = ctx.measure([&] { formatText(sample(i++), text, sizeof(text)); });
+        formatText(sample(7), text, sizeof(text));
+        auto textDecode = ctx.measure([&] {
+            Telemetry t;
+            parseText(text, t);
+            sink = sink + t.temperature;
+        });
+
+        uint8_t wire[sizeof(Telemetry)];
+        auto typedEncode = ctx.measure([&] {
+            Telemetry t = sample(i++);
+            memcpy(wire, EventPayload<Telemetry>::bytes(t), sizeof(t));
+            // Keep the copy from being optimized away
+            sink = sink + wire[i % sizeof(wire)];
+        });
+        auto typedDecode = ctx.measure([&] {
+            const Telemetry* t = EventPayload<Telemetry>::view((const char*)wire, sizeof(wire));
+            sink = sink + t->temperature;
+        });
+
+        ctx.report("typed/codec", {
+            {"text_encode_ns", textEncode.nsPerOp()},
+            {"text_decode_ns", textDecode.nsPerOp()},
+            {"typed_encode_ns", typedEncode.nsPerOp()},
+            {"typed_decode_ns", typedDecode.nsPerOp()},
+            {"text_bytes", (double)strlen(text)},
+            {"typed_bytes", (double)sizeof(Telemetry)},
+        });
+    }
+
+    // Whole path: encode, send, parse and handle
+    for (bool typed : {false, true}) {
+        EventMsg tx;
+        EventMsg rx;
+        tx.setAddr(0x01);
+        rx.setAddr(0x02);
+        EventSourceId source = rx.createDirectSource();
+        tx.setWriteCallback([&](uint8_t* data, size_t len) { return rx.process(source, data, len); });
+
+        EventDispatcher dispatcher;
+        dispatcher.registerWith(rx, "bench");
+        double total = 0;
+        uint64_t bad = 0;
+        if (typed) {
+            dispatcher.on<Telemetry>("telemetry", [&](const Telemetry& t, EventHeader&) { total += t.temperature; });
+        } else {
+            dispatcher.on("telemetry", [&](const char* data, size_t, EventHeader&) {
+                Telemetry t;
+                if (!parseText(data, t)) bad++;
+                total += t.temperature;
+            });
+        }
+
+        TypedEvent<Telemetry> telemetry(tx, "telemetry", header);
+        uint32_t i = 0;
+        auto m = ctx.measure([&] {
+            Telemetry t = sample(i++);
+            if (typed) {
+                telemetry.send(t);
+            } else {
+                char text[64];
+                formatText(t, text, sizeof(text));
+                tx.send("telemetry", text, header);
+            }
+        });
+
+        ctx.report(std::string("typed/end_to_end/") + (typed ? "struct" : "text"), {
+            {"ns_per_message", m.nsPerOp()},
+            {"allocs_per_message", m.allocsPerOp()},
+            {"parse_errors", (double)bad},
+        });
+        rx.removeSource(source);
+    }
+}
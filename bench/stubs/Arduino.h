@@ -0,0 +1,161 @@
+// Minimal Arduino / FreeRTOS surface for building EventMsg on a plain Linux
+// host. Only what the library uses is provided; timing comes from
+// std::chrono and FreeRTOS primitives map onto std:: mutexes.
+#ifndef EVENTMSG_BENCH_ARDUINO_STUB_H
+#define EVENTMSG_BENCH_ARDUINO_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Timing
+
+inline unsigned long millis() {
+    using namespace std::chrono;
+    static const auto start = steady_clock::now();
+    return (unsigned long)duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    static const auto start = steady_clock::now();
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// FreeRTOS
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Every semaphore is a recursive mutex, which covers both mutex flavours
+typedef std::recursive_timed_mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new std::recursive_timed_mutex();
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return new std::recursive_timed_mutex();
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+    delete mutex;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        mutex->lock();
+        return pdTRUE;
+    }
+    // Poll try_lock rather than try_lock_for: ThreadSanitizer does not see
+    // the timed lock and would report every matching unlock
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+    while (!mutex->try_lock()) {
+        if (std::chrono::steady_clock::now() >= deadline) return pdFALSE;
+        std::this_thread::yield();
+    }
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    mutex->unlock();
+    return pdTRUE;
+}
+
+#define xSemaphoreTakeRecursive(mutex, ticks) xSemaphoreTake(mutex, ticks)
+#define xSemaphoreGiveRecursive(mutex) xSemaphoreGive(mutex)
+
+// Critical sections map onto a recursive mutex on the host
+struct portMUX_TYPE {
+    std::recursive_mutex m;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portMUX_INITIALIZE(mux) ((void)(mux))
+#define portENTER_CRITICAL(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL(mux)  (mux)->m.unlock()
+// "ISRs" on the host are just other threads
+#define portENTER_CRITICAL_ISR(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL_ISR(mux)  (mux)->m.unlock()
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+// Task notifications as a counting semaphore per thread
+struct StubTask {
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t count = 0;
+};
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    thread_local StubTask task;
+    return &task;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+    StubTask* task = static_cast<StubTask*>(handle);
+    {
+        std::lock_guard<std::mutex> guard(task->m);
+        task->count++;
+    }
+    task->cv.notify_one();
+    return pdPASS;
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t* higherPriorityTaskWoken) {
+    xTaskNotifyGive(handle);
+    if (higherPriorityTaskWoken != nullptr) *higherPriorityTaskWoken = pdTRUE;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    StubTask* task = static_cast<StubTask*>(xTaskGetCurrentTaskHandle());
+    std::unique_lock<std::mutex> lock(task->m);
+    auto ready = [task] { return task->count > 0; };
+    if (ticks == portMAX_DELAY) {
+        task->cv.wait(lock, ready);
+    } else if (!task->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready)) {
+        return 0;
+    }
+    uint32_t count = task->count;
+    task->count = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+// Tasks are detached threads. The host scheduler picks cores, so the
+// affinity is ignored; portNUM_PROCESSORS matches the ESP32.
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                          UBaseType_t, TaskHandle_t* created, BaseType_t) {
+    std::thread([fn, arg] { fn(arg); }).detach();
+    if (created != nullptr) *created = nullptr;  // Tasks look themselves up
+    return pdPASS;
+}
+
+// Only vTaskDelete(nullptr) at the end of a task is supported: the thread returns
+inline void vTaskDelete(TaskHandle_t) {}
+
+#endif // EVENTMSG_BENCH_ARDUINO_STUB_H
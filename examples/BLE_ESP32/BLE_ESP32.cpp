@@ -18,7 +18,7 @@
 #define CHARACTERISTIC_UUID_TX "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
 
 EventMsg eventMsg;
-uint8_t bleSourceId; // Will be assigned during setup
+EventSourceId bleSourceId; // Will be assigned during setup
 
 // Create separate dispatchers for different message types
 EventDispatcher HeliosDis(DEVICEBROADCAST,DEVICE01,GROUP00);        // Mobile app messages
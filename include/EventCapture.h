@@ -0,0 +1,137 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include "EventMsg.h"
+#include <stdio.h>
+
+// Log layout, all integers little-endian:
+//   file header: "EVCP" version(1) reserved(3)
+//   record:      timestampUs(4) sourceId(2) direction(1) length(2) bytes(length)
+// Timestamps are micros() and may wrap; replay only uses differences.
+#define CAPTURE_MAGIC         "EVCP"
+#define CAPTURE_VERSION       1
+#define CAPTURE_FILE_HEADER   8
+#define CAPTURE_RECORD_HEADER 9
+#define CAPTURE_MAX_RECORD    0xFFFF  // Longer writes are split across records
+
+// Records raw traffic from EventMsg's capture tap: every byte passed to
+// process() and every frame a transport accepted, tagged with time, source
+// and direction.
+//
+// Sinks are a RAM ring (oldest records are overwritten, whole) and/or an
+// append-only file. Either can be on at once. record() takes a mutex, so
+// process() and send() may run on different threads.
+class EventCapture {
+public:
+    struct Stats {
+        uint32_t records = 0;
+        uint32_t bytes = 0;
+        uint32_t overwritten = 0;   // Ring records evicted to make room
+        uint32_t dropped = 0;       // Too large for the ring, or the file write failed
+    };
+
+    // ringBytes = 0 disables the RAM ring
+    explicit EventCapture(size_t ringBytes = 0);
+    ~EventCapture();
+
+    void attach(EventMsg& eventMsg);
+    void detach(EventMsg& eventMsg);
+
+    // Append to a log file, writing the file header if it is empty
+    bool openFile(const char* path);
+    void closeFile();
+
+    void record(uint8_t direction, EventSourceId sourceId, const uint8_t* data, size_t length);
+
+    // Copy the ring, oldest first, as a complete log for EventReplay or a file
+    size_t snapshot(PSRAMVector<uint8_t>& out) const;
+    void clear();
+
+    size_t ringUsed() const { return ringLen; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    void ringWrite(const uint8_t* data, size_t length);
+    void ringRead(size_t offset, uint8_t* out, size_t length) const;
+    void ringEvictOldest();
+
+    PSRAMVector<uint8_t> ring;
+    size_t ringHead = 0;   // Oldest record
+    size_t ringLen = 0;
+    FILE* file = nullptr;
+    SemaphoreHandle_t lock = nullptr;
+    Stats stats;
+};
+
+// Feeds a capture log back through EventMsg::process().
+//
+// RX records go to process() on their recorded source (or one source, if
+// set), so the parser sees the same chunks it saw live. TX records are
+// skipped unless a TX callback is set. Paced replay reproduces the recorded
+// gaps, scaled by speed; unpaced replay runs as fast as possible.
+class EventReplay {
+public:
+    using TxCallback = std::function<void(EventSourceId sourceId, const uint8_t* data, size_t length)>;
+
+    struct Stats {
+        uint32_t records = 0;     // RX records fed to process()
+        uint64_t bytes = 0;
+        uint32_t parseErrors = 0; // process() returned false
+        uint32_t skipped = 0;     // TX records
+    };
+
+    explicit EventReplay(EventMsg& eventMsg) : eventMsg(eventMsg) {}
+    ~EventReplay() { close(); }
+
+    // Replay from memory (not copied; must outlive the replay) or a file
+    bool load(const uint8_t* log, size_t length);
+    bool open(const char* path);
+    void close();
+
+    void setPaced(bool paced, float speed = 1.0f) { this->paced = paced; this->speed = speed > 0 ? speed : 1.0f; }
+    // Send every RX record to this source instead of the recorded one
+    void setSource(EventSourceId sourceId) { sourceOverride = sourceId; }
+    void onTx(TxCallback cb) { txCallback = cb; }
+
+    // Feed every record that is due; returns false once the log is done.
+    // Call from loop() for paced replay.
+    bool update();
+    // Feed the rest of the log, blocking through the gaps if paced
+    void run();
+    void rewind();
+
+    bool done() const { return finished; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    bool readRecord();
+    void feed();
+
+    EventMsg& eventMsg;
+    const uint8_t* mem = nullptr;
+    size_t memLen = 0;
+    size_t memPos = 0;
+    FILE* file = nullptr;
+
+    bool paced = false;
+    float speed = 1.0f;
+    EventSourceId sourceOverride = 0;
+    TxCallback txCallback;
+
+    // Record read ahead but not yet fed
+    bool havePending = false;
+    EventSourceId pendingSource = 0;
+    uint8_t pendingDir = 0;
+    PSRAMVector<uint8_t> pendingData;
+
+    bool started = false;
+    bool finished = false;
+    bool haveTs = false;
+    uint32_t lastTs = 0;
+    uint64_t logElapsedUs = 0;    // Recorded time of the pending record since the first
+    uint32_t lastWallUs = 0;
+    uint64_t wallElapsedUs = 0;   // Accumulated so micros() wrap doesn't matter
+    Stats stats;
+};
+
+#endif // EVENT_CAPTURE_H
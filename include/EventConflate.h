@@ -0,0 +1,128 @@
+#ifndef EVENT_CONFLATE_H
+#define EVENT_CONFLATE_H
+
+#include "EventMsg.h"
+#include "EventSlab.h"
+#include "EventTopic.h"
+
+// Latest-value-wins coalescing for telemetry-style events.
+//
+// Receiving side: frames whose name matches a pattern given to
+// setConflated() are held instead of dispatched, one slot per (sender,
+// event). A newer frame for a slot that has not gone out yet overwrites
+// it in place. dispatch() then runs the handlers once per slot, so a
+// backlog of stale samples costs one handler call per key rather than one
+// per frame.
+//
+// Sending side: sendConflated() holds the payload in a slot per
+// (receiver, group, event) and flush() sends each slot once. Calling it
+// faster than the link drains, or than the flush interval, overwrites the
+// pending value rather than queueing another frame. A send that fails
+// (e.g. a link paused by FlowControl) stays pending for the next flush.
+//
+// Keys keep the position of their first pending value, so slots go out in
+// the order the keys first became pending. Slots and their payload buffers
+// are allocated once. When every slot is taken, a new key on receive is
+// dispatched straight through; on send it is sent at once.
+class Conflator {
+public:
+    struct Config {
+        uint16_t slots;           // Keys pending at once, per direction
+        uint16_t payloadReserve;  // Bytes reserved per slot up front; a bigger payload grows its slot once
+        uint16_t sendInterval;    // Minimum ms between sends from update(); 0 = every call
+        Config(uint16_t slots = 16, uint16_t reserve = 64, uint16_t interval = 0)
+            : slots(slots), payloadReserve(reserve), sendInterval(interval) {}
+    };
+
+    struct Stats {
+        uint32_t received = 0;      // Conflated frames held
+        uint32_t rxReplaced = 0;    // ... that overwrote a pending one
+        uint32_t dispatched = 0;
+        uint32_t queued = 0;        // sendConflated() calls held
+        uint32_t txReplaced = 0;    // ... that overwrote a pending one
+        uint32_t sent = 0;
+        uint32_t overflow = 0;      // No free slot: passed straight through
+    };
+
+    Conflator(EventMsg& eventMsg, const Config& config = Config());
+    ~Conflator();
+
+    // Register the receive filter. Begin this after dedupe, reliable and
+    // flow control, and before DeferredDispatch.
+    bool begin(const char* name);
+    // Stop holding received frames. Held ones go out on the next dispatch().
+    void end();
+
+    // Conflate received events matching pattern ("sensordata", "sensor/#");
+    // see EventDispatcher::on() for the wildcards
+    void setConflated(const char* pattern, bool enabled = true);
+
+    // Run handlers for up to maxEvents held events (0 = all) and return how
+    // many ran. Call from one task at a time.
+    size_t dispatch(size_t maxEvents = 0);
+
+    // Hold a value for sending, replacing any not yet sent to the same
+    // receiver and group. Returns false only if it had to be sent at once
+    // and that failed.
+    bool sendConflated(const char* name, const uint8_t* data, size_t length, const EventHeader& header);
+    bool sendConflated(const char* name, const char* data, const EventHeader& header) {
+        return sendConflated(name, (const uint8_t*)data, strlen(data), header);
+    }
+    // Send every pending value; returns how many went out
+    size_t flush();
+
+    // dispatch(), plus flush() once sendInterval has passed; call from loop()
+    void update();
+
+    size_t pendingReceived() const;
+    size_t pendingSends() const;
+    Stats getStats() const;
+
+private:
+    static const uint16_t NONE = 0xFFFF;  // Same as EventSlab::NONE
+
+    struct Slot {
+        uint16_t key = 0;              // senderId on receive, receiverId:groupId on send
+        EventHeader header{};
+        char name[MAX_EVENT_NAME_SIZE + 1];
+        PSRAMVector<uint8_t> payload;  // NUL-terminated like the parser's buffer
+        size_t length = 0;
+        uint16_t next = NONE;
+    };
+
+    // Pending slots in first-pending order; the caller locks
+    struct Table {
+        EventSlab<Slot> slab;
+        uint16_t head = NONE;
+        uint16_t tail = NONE;
+
+        Table(size_t slots, size_t reserve);
+        uint16_t find(uint16_t key, const char* name) const;
+        // Overwrite the key's pending slot or take a new one; NONE when full
+        uint16_t store(uint16_t key, const char* name, const uint8_t* data, size_t length,
+                       const EventHeader& header, bool& replaced);
+        uint16_t pop();
+        void pushFront(uint16_t index);
+    };
+
+    static uint16_t sendKey(const EventHeader& header) {
+        return (uint16_t)((header.receiverId << 8) | header.groupId);
+    }
+
+    bool hold(const char* eventName, const uint8_t* data, size_t length, const EventHeader& header);
+
+    EventMsg& eventMsg;
+    Config config;
+    std::string filterName;
+
+    // Taken briefly by the parser, senders and the flushing task; never
+    // held while a handler or transport runs
+    SemaphoreHandle_t lock = nullptr;
+    TopicTrie patterns;
+    Table received;
+    Table sends;
+    uint32_t lastFlush = 0;
+    Stats stats;
+};
+
+#endif // EVENT_CONFLATE_H
@@ -0,0 +1,84 @@
+#ifndef EVENT_CRC_H
+#define EVENT_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ESP32 ROM CRC routines (exposed through esp_rom_crc.h since ESP-IDF 4.x)
+#if defined(ESP32) && defined(__has_include)
+#if __has_include(<esp_rom_crc.h>)
+#include <esp_rom_crc.h>
+#define EVENT_CRC_USE_ROM 1
+#endif
+#endif
+#ifndef EVENT_CRC_USE_ROM
+#define EVENT_CRC_USE_ROM 0
+#endif
+
+// Bulk CRC-32 uses slice-by-8 tables on the host, ROM routines on ESP32
+#if EVENT_CRC_USE_ROM
+#define EVENT_CRC32_SLICES 1
+#else
+#define EVENT_CRC32_SLICES 8
+#endif
+
+// CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, trailer sent MSB first
+#define EVENT_CRC16_INIT    0xFFFF
+#define EVENT_CRC16_RESIDUE 0x0000
+
+// CRC-32/ISO-HDLC (zlib): reflected poly 0xEDB88320, trailer sent LSB first
+#define EVENT_CRC32_INIT    0xFFFFFFFF
+#define EVENT_CRC32_RESIDUE 0xDEBB20E3
+
+// All functions work on the raw CRC register so that the parser can feed
+// bytes one at a time and compare the register against the residue once the
+// trailer itself has been fed through. Use crc32Final() to get the value
+// that goes on the wire.
+class EventCrc {
+public:
+    struct Tables {
+        uint16_t crc16[256];
+        uint32_t crc32[EVENT_CRC32_SLICES][256];
+    };
+
+    static const Tables tables;
+
+    static inline uint16_t crc16Update(uint16_t crc, uint8_t byte) {
+        return (uint16_t)((crc << 8) ^ tables.crc16[(uint8_t)((crc >> 8) ^ byte)]);
+    }
+
+    static inline uint32_t crc32Update(uint32_t crc, uint8_t byte) {
+        return (crc >> 8) ^ tables.crc32[0][(uint8_t)(crc ^ byte)];
+    }
+
+    static inline uint32_t crc32Final(uint32_t crc) {
+        return ~crc;
+    }
+
+    static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t len);
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+private:
+    static constexpr Tables makeTables() {
+        Tables t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint16_t c16 = (uint16_t)(i << 8);
+            uint32_t c32 = i;
+            for (int bit = 0; bit < 8; bit++) {
+                c16 = (c16 & 0x8000) ? (uint16_t)((c16 << 1) ^ 0x1021) : (uint16_t)(c16 << 1);
+                c32 = (c32 & 1) ? (c32 >> 1) ^ 0xEDB88320 : (c32 >> 1);
+            }
+            t.crc16[i] = c16;
+            t.crc32[0][i] = c32;
+        }
+        for (int slice = 1; slice < EVENT_CRC32_SLICES; slice++) {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t prev = t.crc32[slice - 1][i];
+                t.crc32[slice][i] = (prev >> 8) ^ t.crc32[0][prev & 0xFF];
+            }
+        }
+        return t;
+    }
+};
+
+#endif // EVENT_CRC_H
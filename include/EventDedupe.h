@@ -0,0 +1,54 @@
+#ifndef EVENT_DEDUPE_H
+#define EVENT_DEDUPE_H
+
+#include "EventMsg.h"
+
+#define DEDUPE_WINDOW 64  // msgIds remembered per sender (bitmap width)
+
+// Receive-side duplicate suppression keyed by (senderId, msgId).
+//
+// Keeps a per-sender sliding bitmap over the last DEDUPE_WINDOW msgIds in a
+// small open-addressing table, so copies of a frame that arrive over several
+// transports or relays are dispatched once. Register it before any other
+// receive filter so duplicates are dropped before they cost anything else.
+//
+// Frames flagged EVENT_FLAG_RELIABLE or EVENT_FLAG_RESPONSE are passed
+// through untouched: their msgId is not drawn from the sender's own counter.
+class DuplicateFilter {
+public:
+    struct Stats {
+        uint32_t hits = 0;       // Duplicates dropped
+        uint32_t misses = 0;     // New frames passed on
+        uint32_t resets = 0;     // msgId jumped outside the window (sender restart)
+        uint32_t evictions = 0;  // Sender replaced because the table was full
+    };
+
+    // capacity is rounded up to a power of two
+    DuplicateFilter(EventMsg& eventMsg, size_t capacity = 16);
+    ~DuplicateFilter();
+
+    bool begin(const char* name);
+    void end();
+
+    // Returns true if (senderId, msgId) was already seen, and records it
+    bool check(uint8_t senderId, uint16_t msgId);
+    void clear();
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Entry {
+        bool used = false;
+        uint8_t senderId = 0;
+        uint16_t highest = 0;    // Newest msgId seen
+        uint64_t seen = 0;       // Bit i set: highest - i seen
+    };
+
+    EventMsg& eventMsg;
+    PSRAMVector<Entry> table;
+    size_t mask;
+    std::string filterName;
+    Stats stats;
+};
+
+#endif // EVENT_DEDUPE_H
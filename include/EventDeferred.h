@@ -0,0 +1,100 @@
+#ifndef EVENT_DEFERRED_H
+#define EVENT_DEFERRED_H
+
+#include "EventMsg.h"
+#include "EventSlab.h"
+
+// Runs handlers outside the parser.
+//
+// Registered as the last receive filter, it copies each completed frame
+// into a slab-backed queue and stops it there. dispatch() later hands the
+// queued frames to the handlers through EventMsg::deliver(). Parsing, and
+// the filters ahead of this one (dedupe, reliable ACKs, flow control),
+// keep pace with the link while a slow handler works through the backlog,
+// either from loop() or on a task of its own (pinned to the other core if
+// you like).
+//
+// Events from one source are always dispatched in arrival order. With
+// ORDER_PER_SOURCE, sources take turns, so a burst on one link cannot hold
+// up another. With ORDER_ARRIVAL, everything goes out in global arrival order.
+//
+// Slots and their payload buffers are allocated once and reused. When
+// every slot is taken, new frames are dropped and counted, so size the
+// queue for the longest handler stall you expect.
+class DeferredDispatch {
+public:
+    enum Order : uint8_t {
+        ORDER_PER_SOURCE,  // FIFO per source, sources served round-robin
+        ORDER_ARRIVAL      // One FIFO across all sources
+    };
+
+    struct Config {
+        uint16_t slots;           // Events held at once
+        uint16_t payloadReserve;  // Bytes reserved per slot up front; a bigger payload grows its slot once
+        Order order;
+        Config(uint16_t slots = 16, uint16_t reserve = 128, Order order = ORDER_PER_SOURCE)
+            : slots(slots), payloadReserve(reserve), order(order) {}
+    };
+
+    struct Stats {
+        uint32_t queued = 0;
+        uint32_t dispatched = 0;
+        uint32_t dropped = 0;     // Queue was full
+        uint16_t highWater = 0;   // Most events queued at once
+    };
+
+    DeferredDispatch(EventMsg& eventMsg, const Config& config = Config());
+    ~DeferredDispatch();
+
+    // Register the receive filter. Begin this after every other layer so
+    // their filters still run inline.
+    bool begin(const char* name);
+    // Stop queueing. Events already queued go out on the next dispatch().
+    void end();
+
+    // Run handlers for up to maxEvents queued events (0 = until empty) and
+    // return how many ran. Call from one task at a time.
+    size_t dispatch(size_t maxEvents = 0);
+
+    // Task notified whenever an event is queued; wait with ulTaskNotifyTake()
+    void setNotifyTask(TaskHandle_t task);
+
+    size_t pending() const;
+    Stats getStats() const;
+
+private:
+    static const uint16_t NONE = 0xFFFF;  // Same as EventSlab::NONE
+
+    struct Slot {
+        EventSourceId sourceId = 0;
+        EventHeader header{};
+        char name[MAX_EVENT_NAME_SIZE + 1];
+        PSRAMVector<uint8_t> payload;  // NUL-terminated like the parser's buffer
+        size_t length = 0;
+        uint16_t next = NONE;          // Next slot in the same lane
+    };
+
+    struct Lane {
+        uint16_t head = NONE;
+        uint16_t tail = NONE;
+    };
+
+    bool enqueue(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length,
+                 const EventHeader& header);
+    uint16_t takeLocked();
+
+    EventMsg& eventMsg;
+    Config config;
+    std::string filterName;
+
+    // Taken briefly by the parsing task(s) and the dispatching task; never
+    // held while a handler runs
+    SemaphoreHandle_t lock = nullptr;
+    EventSlab<Slot> slab;
+    std::map<EventSourceId, Lane> lanes;  // One entry per source seen (just 0 for ORDER_ARRIVAL)
+    EventSourceId lastLane = 0;           // Round-robin position
+    TaskHandle_t notifyTask = nullptr;
+    Stats stats;
+};
+
+#endif // EVENT_DEFERRED_H
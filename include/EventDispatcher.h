@@ -2,6 +2,9 @@
 #define EVENT_DISPATCHER_H
 
 #include "EventMsg.h"
+#include "EventExecutor.h"
+#include "EventTopic.h"
+#include "EventTyped.h"
 #include <map>
 #include <string>
 
@@ -14,18 +17,83 @@ public:
     EventDispatcher(uint8_t localAddr = 0x00, uint8_t receiverId = 0xFF, uint8_t groupId = 0x00) 
         : localAddress(localAddr), listenReceiverId(receiverId), listenGroupId(groupId) {}
     
-    // Register event handler
-    void on(const char* eventName, EventCallback callback) {
-        handlers[eventName] = callback;
+    // Register event handler; safe while events are being dispatched.
+    // eventName may be a topic pattern: "*" matches one '/'-separated
+    // level and a final "#" any number of them ("sensor/temp/*",
+    // "sensor/#"). Every matching pattern runs, as well as the handler
+    // registered for the exact name. Registering a name again replaces
+    // its handler.
+    // policy picks where it runs (see ExecPolicy); anything but INLINE
+    // needs setExecutor(), and runs inline while no executor is running.
+    void on(const char* eventName, EventCallback callback, const ExecPolicy& policy = ExecPolicy()) {
+        Registration registration{
+            std::make_shared<const EventCallback>(std::move(callback)),
+            policy
+        };
+        handlers.update([&](HandlerTable& table) {
+            auto it = table.ids.find(eventName);
+            if (it != table.ids.end()) {
+                table.registrations[it->second] = registration;
+                return true;
+            }
+            // Reuse a slot freed by off() before growing
+            uint16_t id = 0;
+            while (id < table.registrations.size() && table.registrations[id].callback) id++;
+            if (id == table.registrations.size()) {
+                table.registrations.push_back(registration);
+            } else {
+                table.registrations[id] = registration;
+            }
+            table.ids[eventName] = id;
+            table.trie.insert(eventName, id);
+            return true;
+        });
+    }
+
+    // Handler for a typed payload (see EventTyped.h): gets the payload as a
+    // T viewed in place, without a copy. Frames too short for T are
+    // skipped.
+    template <typename T>
+    void on(const char* eventName, std::function<void(const T& payload, EventHeader& header)> handler,
+            const ExecPolicy& policy = ExecPolicy()) {
+        on(eventName, [handler](const char* data, size_t length, EventHeader& header) {
+            const T* payload = EventPayload<T>::view(data, length);
+            if (payload != nullptr) {
+                handler(*payload, header);
+            }
+        }, policy);
+    }
+
+    // Remove the handler registered under exactly this name or pattern
+    bool off(const char* eventName) {
+        return handlers.update([&](HandlerTable& table) {
+            auto it = table.ids.find(eventName);
+            if (it == table.ids.end()) return false;
+            table.trie.remove(eventName, it->second);
+            table.registrations[it->second].callback.reset();
+            table.ids.erase(it);
+            return true;
+        });
     }
     
     // Handle incoming event
     void dispatchEvent(const char* eventName, const char* data, size_t length, EventHeader& header) {
-        auto it = handlers.find(eventName);
-        if (it != handlers.end()) {
-            it->second(data, length, header);
-        }
+        RcuPtr<HandlerTable>::Reader table(handlers);
+        uint32_t key = 0;
+        bool keyed = false;
+        table->trie.match(eventName, [&](uint16_t id) {
+            const Registration& registration = table->registrations[id];
+            // ORDER_EVENT orders by the concrete name, not the pattern it matched
+            if (registration.policy.order == ExecPolicy::ORDER_EVENT && !keyed) {
+                key = eventKey(eventName);
+                keyed = true;
+            }
+            run(registration, key, data, length, header);
+        });
     }
+
+    // Worker pool for handlers registered as POOLED or PINNED
+    void setExecutor(EventExecutor* pool) { executor = pool; }
     
     // Get dispatcher callback for EventMsg registration
     EventDispatcherCallback getHandler() {
@@ -50,7 +118,8 @@ public:
             localAddress,          // our address as sender
             originalHeader.senderId, // original sender becomes receiver
             0x00,                  // no group
-            0x00                   // no flags
+            EVENT_FLAG_RESPONSE,   // reply to originalHeader.msgId
+            originalHeader.msgId
         };
     }
     
@@ -82,7 +151,39 @@ public:
     void setGroupId(uint8_t id) { listenGroupId = id; }
 
 private:
-    std::map<std::string, EventCallback> handlers;
+    struct Registration {
+        std::shared_ptr<const EventCallback> callback;  // Shared with queued executor jobs
+        ExecPolicy policy;
+    };
+
+    // FNV-1a of the event name
+    static uint32_t eventKey(const char* eventName) {
+        uint32_t hash = 2166136261u;
+        for (const char* p = eventName; *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Exact names and patterns share the trie; a name without wildcards
+    // is just a literal path through it
+    struct HandlerTable {
+        PSRAMVector<Registration> registrations;  // Indexed by trie id; empty callback = free
+        std::map<std::string, uint16_t> ids;      // Name or pattern -> id, for on()/off()
+        TopicTrie trie;
+    };
+
+    void run(const Registration& registration, uint32_t key, const char* data, size_t length, EventHeader& header) {
+        EventExecutor* pool = executor;
+        if (registration.policy.mode == ExecPolicy::INLINE || pool == nullptr || !pool->isRunning()) {
+            (*registration.callback)(data, length, header);
+        } else {
+            pool->post(registration.callback, registration.policy, key, data, length, header);
+        }
+    }
+
+    RcuPtr<HandlerTable> handlers;  // Copy-on-write, see EventRcu.h
+    EventExecutor* executor = nullptr;
     uint8_t localAddress;
     uint8_t listenReceiverId;
     uint8_t listenGroupId;
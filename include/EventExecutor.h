@@ -0,0 +1,137 @@
+#ifndef EVENT_EXECUTOR_H
+#define EVENT_EXECUTOR_H
+
+#include "EventMsg.h"
+#include "EventSlab.h"
+#include <memory>
+
+// Where an EventDispatcher handler runs, and what it must stay ordered with
+struct ExecPolicy {
+    enum Mode : uint8_t {
+        INLINE,  // On the task that parsed the frame (default)
+        POOLED,  // On any executor worker
+        PINNED   // On a worker pinned to `core`
+    };
+    enum Order : uint8_t {
+        ORDER_NONE,    // May run in parallel with anything
+        ORDER_SENDER,  // In arrival order with other events from the same sender
+        ORDER_EVENT    // In arrival order with other occurrences of the same event
+    };
+
+    Mode mode = INLINE;
+    Order order = ORDER_NONE;
+    uint8_t core = 0;
+
+    static ExecPolicy inlined() { return ExecPolicy(); }
+    static ExecPolicy pooled(Order order = ORDER_NONE) {
+        ExecPolicy policy;
+        policy.mode = POOLED;
+        policy.order = order;
+        return policy;
+    }
+    static ExecPolicy pinned(uint8_t core, Order order = ORDER_NONE) {
+        ExecPolicy policy = pooled(order);
+        policy.mode = PINNED;
+        policy.core = core;
+        return policy;
+    }
+};
+
+// Worker pool for EventDispatcher handlers (EventDispatcher::setExecutor).
+//
+// Each worker is a FreeRTOS task with its own FIFO; worker i is pinned to
+// core i % portNUM_PROCESSORS unless Config::pinned is false. An ordered
+// job goes to the worker its key hashes to, so jobs sharing a key run one
+// after another in arrival order while other keys run in parallel.
+// Unordered jobs go to the next worker round-robin, and a worker that runs
+// dry steals unordered POOLED jobs from the others. PINNED jobs never leave
+// their core.
+//
+// Jobs and their payload copies live in a fixed slab allocated up front.
+// When every slot is busy, post() drops the job and counts it.
+class EventExecutor {
+public:
+    using Handler = std::function<void(const char* data, size_t length, EventHeader& header)>;
+
+    struct Config {
+        uint8_t workers;          // Tasks in the pool
+        uint16_t slots;           // Jobs queued or running at once
+        uint16_t payloadReserve;  // Bytes reserved per slot up front; a bigger payload grows its slot once
+        uint32_t stackSize;       // Per worker task
+        UBaseType_t priority;
+        bool pinned;              // Pin worker i to core i % portNUM_PROCESSORS
+        Config(uint8_t workers = 2, uint16_t slots = 32, uint16_t reserve = 128,
+               uint32_t stack = 4096, UBaseType_t priority = 1, bool pinned = true)
+            : workers(workers), slots(slots), payloadReserve(reserve), stackSize(stack),
+              priority(priority), pinned(pinned) {}
+    };
+
+    struct Stats {
+        uint32_t posted = 0;
+        uint32_t executed = 0;
+        uint32_t stolen = 0;   // Jobs run by a worker other than the one posted to
+        uint32_t dropped = 0;  // Every slot was busy
+    };
+
+    explicit EventExecutor(const Config& config = Config());
+    // Stops the workers after the jobs they are running; queued jobs are discarded
+    ~EventExecutor();
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running.load(); }
+
+    // Queue handler(data, length, header) for a worker. eventKey identifies
+    // the event for ORDER_EVENT. Returns false if dropped or not running.
+    bool post(const std::shared_ptr<const Handler>& handler, const ExecPolicy& policy, uint32_t eventKey,
+              const char* data, size_t length, const EventHeader& header);
+
+    // Jobs queued or running
+    size_t pending() const;
+    Stats getStats() const;
+    uint8_t getWorkerCount() const { return (uint8_t)workers.size(); }
+
+private:
+    static const uint16_t NONE = 0xFFFF;  // Same as EventSlab::NONE
+
+    struct Job {
+        std::shared_ptr<const Handler> handler;
+        EventHeader header{};
+        PSRAMVector<uint8_t> payload;  // NUL-terminated like the parser's buffer
+        size_t length = 0;
+        uint16_t next = NONE;
+    };
+
+    struct Fifo {
+        uint16_t head = NONE;
+        uint16_t tail = NONE;
+    };
+
+    struct Worker {
+        EventExecutor* owner = nullptr;
+        uint8_t index = 0;
+        BaseType_t core = tskNO_AFFINITY;
+        TaskHandle_t task = nullptr;  // Set by the worker itself once running
+        Fifo own;                     // Ordered or pinned jobs: only this worker runs them
+        Fifo shared;                  // Pooled unordered jobs: idle workers steal them
+        bool idle = false;
+    };
+
+    static void workerMain(void* arg);
+    void runWorker(Worker& worker);
+    uint16_t takeLocked(Worker& worker);
+    void pushLocked(Fifo& fifo, uint16_t index);
+    uint16_t popLocked(Fifo& fifo);
+    uint8_t pickWorker(const ExecPolicy& policy, uint32_t key);
+
+    Config config;
+    SemaphoreHandle_t lock = nullptr;  // Guards the slab, the FIFOs and stats; never held while a handler runs
+    EventSlab<Job> slab;
+    PSRAMVector<Worker> workers;
+    uint8_t nextWorker = 0;            // Round-robin position for unordered jobs
+    std::atomic<bool> running;
+    std::atomic<uint8_t> exited;
+    Stats stats;
+};
+
+#endif // EVENT_EXECUTOR_H
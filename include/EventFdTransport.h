@@ -0,0 +1,136 @@
+#ifndef EVENT_FD_TRANSPORT_H
+#define EVENT_FD_TRANSPORT_H
+
+#include "EventMsg.h"
+
+// Host-only: needs epoll, so it is compiled out of Arduino builds
+#if defined(__linux__) && !defined(ARDUINO)
+#define EVENT_FD_TRANSPORT_AVAILABLE 1
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#define FD_READ_CHUNK     4096   // Bytes per read() into EventMsg::process
+#define FD_READS_PER_WAKE 4      // Bound per fd and wakeup so busy fds can't starve the rest
+#define FD_MAX_EVENTS     64
+
+// Called on the reactor thread after an fd hit EOF or an error and was closed
+using FdCloseCallback = std::function<void(EventSourceId sourceId, int fd)>;
+// Called on the reactor thread with each connection accepted on a listener
+using FdAcceptCallback = std::function<void(int fd)>;
+
+// epoll transport for Linux hosts: serial ttys, ptys, pipes and sockets.
+//
+// Each fd gets its own source. One reactor reads every fd nonblocking and
+// hands the bytes straight to EventMsg::process, skipping the source queue
+// and its 512-byte packet limit. Sends go through the source's transport:
+// they write directly while the fd accepts data and park the remainder in a
+// per-fd buffer that the reactor drains on EPOLLOUT.
+//
+// All handlers run on the reactor thread (or the caller of poll()), which
+// must be the only thread calling EventMsg::process.
+class FdTransport {
+public:
+    // Updated from the reactor and from sending threads
+    struct Stats {
+        std::atomic<uint64_t> bytesIn{0};
+        std::atomic<uint64_t> bytesOut{0};
+        std::atomic<uint32_t> reads{0};
+        std::atomic<uint32_t> partialWrites{0};  // Writes that had to be buffered
+        std::atomic<uint32_t> writeDrops{0};     // Frames refused: write buffer full or fd closed
+        std::atomic<uint32_t> closed{0};
+    };
+
+    explicit FdTransport(EventMsg& eventMsg, size_t maxPendingWrite = 64 * 1024);
+    ~FdTransport();
+
+    // Create the epoll set; start() also spawns the reactor thread
+    bool begin();
+    void end();
+    bool start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Run one reactor iteration on the calling thread; returns events handled
+    int poll(int timeoutMs);
+
+    // Register an fd and return its new source ID, 0 on failure. The fd is
+    // switched to nonblocking mode and closed on removeFd() if ownsFd is set.
+    // onClose, if given, runs for this fd only, before the global callback.
+    //
+    // Source state belongs to the reactor, so from any other thread while
+    // it runs, addFd() and removeFd() hand the work to the reactor and wait
+    // for it: don't call them holding a lock a handler may need.
+    EventSourceId addFd(int fd, bool ownsFd = true, FdCloseCallback onClose = nullptr);
+    // Close the fd if owned and remove its source from EventMsg. Once it
+    // returns, no close callback for the fd is running.
+    bool removeFd(EventSourceId sourceId);
+    // Shut a socket down from any thread; the reactor then closes it
+    // through the normal EOF path and runs the close callbacks
+    bool shutdownFd(EventSourceId sourceId);
+    void onClose(FdCloseCallback cb) { closeCallback = cb; }
+
+    // Accept connections on a listening socket; the callback decides
+    // whether to addFd() or close each one
+    bool addListener(int listenFd, FdAcceptCallback cb);
+    bool removeListener(int listenFd);
+
+    size_t getFdCount() const;
+    size_t pendingWrite(EventSourceId sourceId) const;
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Conn {
+        int fd = -1;
+        EventSourceId sourceId = 0;
+        bool ownsFd = true;
+        bool isSocket = false;
+        bool open = true;
+        bool wantWrite = false;       // EPOLLOUT armed
+        std::mutex lock;              // Guards the write side
+        PSRAMVector<uint8_t> pending;
+        size_t pendingOff = 0;
+        FdCloseCallback onClose;
+    };
+    using ConnPtr = std::shared_ptr<Conn>;
+
+    ConnPtr find(EventSourceId sourceId) const;
+    void handleAccept(int listenFd);
+    bool write(Conn& conn, const uint8_t* data, size_t len);
+    ssize_t writeSome(Conn& conn, const uint8_t* data, size_t len);
+    void handleRead(Conn& conn);
+    void handleWrite(Conn& conn);
+    void closeConn(Conn& conn);
+    void arm(Conn& conn, bool wantWrite);
+    EventSourceId addNow(int fd, bool ownsFd, FdCloseCallback onClose);
+    bool removeNow(EventSourceId sourceId);
+    void onReactor(const std::function<void()>& work);
+    void runPosted();
+
+    EventMsg& eventMsg;
+    size_t maxPendingWrite;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::thread reactor;
+    std::atomic<bool> running{false};
+    mutable std::mutex connLock;
+    std::map<EventSourceId, ConnPtr> conns;
+    std::map<int, FdAcceptCallback> listeners;
+    FdCloseCallback closeCallback;
+    // addFd() and removeFd() calls from other threads, for the reactor to
+    // carry out
+    std::mutex postLock;
+    std::condition_variable postDone;
+    std::vector<std::function<void()>> posted;
+    uint64_t postedCount = 0;
+    uint64_t runCount = 0;
+    uint8_t readBuf[FD_READ_CHUNK];
+    Stats stats;
+};
+
+#endif // __linux__ && !ARDUINO
+
+#endif // EVENT_FD_TRANSPORT_H
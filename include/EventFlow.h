@@ -0,0 +1,75 @@
+#ifndef EVENT_FLOW_H
+#define EVENT_FLOW_H
+
+#include "EventMsg.h"
+
+// Link-level control events, sent to the peer on the link they concern
+#define FLOW_XOFF_EVENT "_xoff"  // [holdMs:2] stop sending on this link for up to holdMs
+#define FLOW_XON_EVENT  "_xon"   // resume sending on this link
+
+// XON/XOFF flow control between peers.
+//
+// Receiving side: when a source queue fills to the high watermark, an XOFF
+// goes back out on that source's transport. It is repeated every `refresh`
+// ms while the queue stays above the low watermark, and again whenever a
+// push finds the queue full. Once the queue drains to the low watermark,
+// an XON follows.
+//
+// Sending side: an XOFF pauses the link it arrived on
+// (EventMsg::pauseTransport) until an XON arrives or holdMs passes without
+// a refresh. While a link is paused, sends to it return 0, so the caller
+// can back off instead of overrunning the peer.
+//
+// Only queued sources (createSource) raise signals. Direct sources such as
+// FdTransport already get backpressure from the kernel. One instance per
+// source manager: it owns that manager's flow callback.
+class FlowControl {
+public:
+    struct Config {
+        uint8_t highWater;   // Queued packets that trigger XOFF (queues hold 8)
+        uint8_t lowWater;    // Queued packets at which XON is sent
+        uint16_t holdTime;   // How long (ms) an XOFF pauses the peer without a refresh
+        uint16_t refresh;    // XOFF repeat interval (ms); keep below holdTime
+        Config(uint8_t high = 6, uint8_t low = 2, uint16_t hold = 500, uint16_t refresh = 200)
+            : highWater(high), lowWater(low), holdTime(hold), refresh(refresh) {}
+    };
+
+    struct Stats {
+        uint32_t xoffSent = 0;
+        uint32_t xonSent = 0;
+        uint32_t xoffReceived = 0;
+        uint32_t xonReceived = 0;
+    };
+
+    FlowControl(EventMsg& eventMsg, uint8_t localAddr, const Config& config = Config());
+    ~FlowControl();
+
+    // Register the receive filter and arm the queue watermarks
+    bool begin(const char* name);
+    void end();
+
+    // Repeat XOFF for sources still above the low watermark; call from loop()
+    void update();
+
+    // True between our XOFF and XON for this source
+    bool isThrottled(EventSourceId sourceId) const;
+    const Stats& getStats() const { return stats; }
+
+private:
+    void onSignal(EventSourceId sourceId, uint8_t signal);
+    bool onFrame(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length);
+    void sendControl(EventSourceId sourceId, const char* name, const uint8_t* data, size_t length);
+    void sendXoff(EventSourceId sourceId);
+
+    EventMsg& eventMsg;
+    uint8_t localAddr;
+    Config config;
+    std::string filterName;
+
+    // Signals arrive on the threads pushing and popping the queues
+    SemaphoreHandle_t lock = nullptr;
+    std::map<EventSourceId, uint32_t> throttled;  // Source -> millis() of the last XOFF
+    Stats stats;
+};
+
+#endif // EVENT_FLOW_H
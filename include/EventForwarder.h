@@ -0,0 +1,85 @@
+#ifndef EVENT_FORWARDER_H
+#define EVENT_FORWARDER_H
+
+#include "EventMsg.h"
+
+#define FORWARD_ANY (-1)  // Wildcard for ForwardRule match fields
+
+// Match on the 6-byte header of a frame arriving on `ingress`.
+// First matching rule wins. An empty egress list floods every port
+// except the ingress.
+struct ForwardRule {
+    int32_t ingress = FORWARD_ANY;     // Source the frame arrived on
+    int16_t receiverId = FORWARD_ANY;
+    int16_t groupId = FORWARD_ANY;
+    std::vector<EventSourceId> egress;
+    bool deliverLocal = false;         // Also hand the frame to the local EventMsg
+};
+
+// Gateway fast path.
+//
+// Sits in front of EventMsg::process(). For each frame it unstuffs only the
+// 6-byte header and decides the destination from it. Forwarded frames are
+// copied through with their original stuffed name, data and CRC bytes, and
+// only the header is re-stuffed with the hop count bumped. The body is never
+// unstuffed, dispatched or re-encoded, and it keeps its original msgId.
+// Frames that must also be seen locally are fed to EventMsg::process() as-is.
+//
+// Without a matching rule the forwarder behaves like a learning switch,
+// using the routes EventMsg learns from incoming traffic:
+//   receiver == local address  -> local only
+//   receiver known on a port   -> that port only
+//   broadcast / unknown        -> local + flood other ports
+class EventForwarder {
+public:
+    struct Stats {
+        uint32_t forwarded = 0;   // Frames written to at least one egress
+        uint32_t local = 0;       // Frames handed to EventMsg
+        uint32_t hopLimited = 0;  // Not forwarded: hop count exhausted
+        uint32_t oversize = 0;    // Dropped: frame exceeded the forwarding buffer
+    };
+
+    explicit EventForwarder(EventMsg& eventMsg) : eventMsg(eventMsg) {}
+
+    // Ports take part in flooding; frames are written via EventMsg::writeFrameTo
+    void addPort(EventSourceId sourceId);
+    void removePort(EventSourceId sourceId);
+    void addRule(const ForwardRule& rule) { rules.push_back(rule); }
+    void clearRules() { rules.clear(); }
+
+    // Replaces EventMsg::process / processAllSources on a gateway
+    bool process(EventSourceId sourceId, const uint8_t* data, size_t len);
+    void processAllSources();
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    enum class Phase { IDLE, HEADER, BODY };
+
+    enum class Target { NONE, RULE, ROUTE, FLOOD };
+
+    struct PortState {
+        Phase phase = Phase::IDLE;
+        bool escaped = false;
+        uint8_t header[MAX_HEADER_SIZE];
+        size_t headerLen = 0;
+        uint8_t rawHeader[1 + MAX_HEADER_SIZE * 2];  // SOH + header as received
+        size_t rawHeaderLen = 0;
+        bool local = false;
+        Target target = Target::NONE;
+        size_t rule = 0;              // Index into rules; a pointer would dangle after addRule()
+        EventSourceId routeSource = 0;
+        PSRAMVector<uint8_t> frame;   // Outgoing frame being assembled
+    };
+
+    void decide(EventSourceId sourceId, PortState& port);
+    void emit(EventSourceId sourceId, PortState& port);
+
+    EventMsg& eventMsg;
+    std::vector<EventSourceId> ports;
+    std::vector<ForwardRule> rules;
+    std::map<EventSourceId, PortState> portStates;
+    Stats stats;
+};
+
+#endif // EVENT_FORWARDER_H
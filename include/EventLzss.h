@@ -0,0 +1,39 @@
+#ifndef EVENT_LZSS_H
+#define EVENT_LZSS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Match finder size: 2^bits last-seen positions, kept on the stack while
+// compressing (2 bytes each). More bits find more matches.
+#ifndef EVENT_LZSS_HASH_BITS
+#define EVENT_LZSS_HASH_BITS 8
+#endif
+
+#define EVENT_LZSS_WINDOW    4096  // Farthest a match may reach back
+#define EVENT_LZSS_MIN_MATCH 3
+#define EVENT_LZSS_MAX_MATCH 18
+
+// LZSS payload codec for EVENT_FLAG_COMPRESSED frames.
+//
+// The stream is a sequence of groups: one control byte, then up to eight
+// items, bit 0 first. A set bit is a literal byte. A clear bit is a two
+// byte match, big-endian ((distance - 1) << 4) | (length - 3), copying
+// 3-18 bytes from 1-4096 bytes back in the output. Matches may overlap
+// the bytes they produce.
+//
+// The window is the output itself, so decompressing needs no memory
+// beyond the destination buffer. Compressing needs only the hash table
+// above, on the stack. Both run in a single pass.
+class EventLzss {
+public:
+    // Returns the compressed size, or 0 if it would exceed outputMaxLen.
+    // Pass inputLen - 1 to only accept output that saves space.
+    static size_t compress(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen);
+
+    // Returns the decompressed size, or 0 if the stream is malformed or
+    // does not fit in outputMaxLen
+    static size_t decompress(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen);
+};
+
+#endif // EVENT_LZSS_H
@@ -5,8 +5,12 @@
 #include <functional>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <map>
+#include <set>
 #include <string>
+#include "EventCrc.h"
+#include "EventRcu.h"
 // Debug print macro definition
 // #if ENABLE_EVENT_DEBUG_LOGS
 // #define DEBUG_PRINT(msg, ...) \
@@ -75,9 +79,17 @@ bool operator!=(const PSRAMAllocator<T>&, const PSRAMAllocator<U>&) { return fal
 template <typename T>
 using PSRAMVector = std::vector<T, PSRAMAllocator<T>>;
 
+// Identifies the link a frame arrived on; 0 is never assigned and means "none"
+using EventSourceId = uint16_t;
+
+// Raised by a source queue when it crosses a watermark (see setWatermarks)
+#define FLOW_SIGNAL_NONE 0
+#define FLOW_SIGNAL_XOFF 1  // Filled to the high watermark, or full
+#define FLOW_SIGNAL_XON  2  // Drained to the low watermark
+
 struct RawPacket {
     static const size_t MAX_SIZE = 512;
-    uint8_t sourceId;     // Identify message source
+    EventSourceId sourceId;     // Identify message source
     uint32_t timestamp;   // When packet was received
     uint8_t data[MAX_SIZE];  // Fixed size buffer
     size_t length;
@@ -92,14 +104,24 @@ private:
     mutable size_t tail = 0;
     mutable bool full = false;
     mutable bool initialized = false;
+    size_t highWater = 0;             // 0 = no flow signals
+    size_t lowWater = 0;
+    mutable bool throttled = false;   // Between XOFF and XON
+    mutable uint8_t flowSignal = FLOW_SIGNAL_NONE;
+    // Guards the indices and slots. The mutex orders tasks (and can time
+    // out); this critical section inside it is what keeps ISRs out, and it
+    // is the only lock pushFromISR takes.
+    mutable portMUX_TYPE spin;
 
 public:
     ThreadSafeQueue() : mutex(nullptr) {
+        portMUX_INITIALIZE(&spin);
         initialize();
     }
 
     // Copy constructor - create new mutex for the copy
     ThreadSafeQueue(const ThreadSafeQueue& other) : mutex(nullptr) {
+        portMUX_INITIALIZE(&spin);
         initialize();
         // Copy the data state but not the mutex
         head = other.head;
@@ -109,6 +131,9 @@ public:
         processedPackets = other.processedPackets;
         droppedPackets = other.droppedPackets;
         lastProcessed = other.lastProcessed;
+        highWater = other.highWater;
+        lowWater = other.lowWater;
+        throttled = other.throttled;
     }
 
     // Assignment operator - create new mutex for the copy
@@ -132,6 +157,9 @@ public:
             processedPackets = other.processedPackets;
             droppedPackets = other.droppedPackets;
             lastProcessed = other.lastProcessed;
+            highWater = other.highWater;
+            lowWater = other.lowWater;
+            throttled = other.throttled;
         }
         return *this;
     }
@@ -165,7 +193,7 @@ private:
     static portMUX_TYPE mux;
 
 public:
-    bool push(const uint8_t* data, size_t len, uint8_t sourceId) const {
+    bool push(const uint8_t* data, size_t len, EventSourceId sourceId) const {
         if (len > RawPacket::MAX_SIZE) return false;
         
         // Ensure mutex is initialized
@@ -179,23 +207,28 @@ public:
             return false;
         }
         
-        bool success = false;
-        if (!full) {
-            RawPacket& packet = const_cast<RawPacket&>(buffer[tail]);
-            packet.sourceId = sourceId;
-            packet.timestamp = millis();
-            packet.length = len;
-            memcpy(packet.data, data, len);
-
-            tail = (tail + 1) % QUEUE_SIZE;
-            full = (tail == head);
-            success = true;
-        }
+        uint32_t timestamp = millis();
+        portENTER_CRITICAL(&spin);
+        bool success = enqueueLocked(data, len, sourceId, timestamp);
+        portEXIT_CRITICAL(&spin);
         
         xSemaphoreGive(mutex);
         return success;
     }
 
+    // Push from interrupt context: no mutex, no allocation, never blocks.
+    // The copy runs inside a critical section, so its cost is bounded by
+    // len (at most RawPacket::MAX_SIZE bytes).
+    bool pushFromISR(const uint8_t* data, size_t len, EventSourceId sourceId) const {
+        if (len > RawPacket::MAX_SIZE || !initialized) return false;
+
+        uint32_t timestamp = millis();
+        portENTER_CRITICAL_ISR(&spin);
+        bool success = enqueueLocked(data, len, sourceId, timestamp);
+        portEXIT_CRITICAL_ISR(&spin);
+        return success;
+    }
+
 public:
     bool tryPop(RawPacket& packet) const {
         // Ensure mutex is initialized
@@ -211,9 +244,14 @@ public:
         }
 
         bool success = false;
+        portENTER_CRITICAL(&spin);
         if (head != tail || full) {
-            // Thread-safe read from const buffer
-            packet = buffer[head];
+            // Copy only the bytes in use to keep the critical section short
+            const RawPacket& slot = buffer[head];
+            packet.sourceId = slot.sourceId;
+            packet.timestamp = slot.timestamp;
+            packet.length = slot.length;
+            memcpy(packet.data, slot.data, slot.length);
             head = (head + 1) % QUEUE_SIZE;
             full = false;
             success = true;
@@ -222,19 +260,75 @@ public:
             droppedPackets += packet.timestamp < lastProcessed ? 1 : 0;
             lastProcessed = packet.timestamp;
             processedPackets++;
+
+            if (throttled && countLocked() <= lowWater) {
+                throttled = false;
+                flowSignal = FLOW_SIGNAL_XON;
+            }
         }
+        portEXIT_CRITICAL(&spin);
 
         xSemaphoreGive(mutex);
         return success;
     }
 
+    // Signal FLOW_SIGNAL_XOFF at `high` queued packets and FLOW_SIGNAL_XON
+    // once back down to `low`; high = 0 turns signalling off
+    void setWatermarks(size_t high, size_t low) {
+        if (high > QUEUE_SIZE) high = QUEUE_SIZE;
+        if (low >= high) low = high > 0 ? high - 1 : 0;
+        portENTER_CRITICAL(&spin);
+        highWater = high;
+        lowWater = low;
+        if (high == 0) {
+            throttled = false;
+            flowSignal = FLOW_SIGNAL_NONE;
+        }
+        portEXIT_CRITICAL(&spin);
+    }
+
+    // Return and clear the signal raised by the last watermark crossing
+    uint8_t takeFlowSignal() const {
+        portENTER_CRITICAL(&spin);
+        uint8_t signal = flowSignal;
+        flowSignal = FLOW_SIGNAL_NONE;
+        portEXIT_CRITICAL(&spin);
+        return signal;
+    }
+
 private:
+    // Caller holds the critical section
+    bool enqueueLocked(const uint8_t* data, size_t len, EventSourceId sourceId, uint32_t timestamp) const {
+        bool success = false;
+        if (!full) {
+            RawPacket& packet = buffer[tail];
+            packet.sourceId = sourceId;
+            packet.timestamp = timestamp;
+            packet.length = len;
+            memcpy(packet.data, data, len);
+
+            tail = (tail + 1) % QUEUE_SIZE;
+            full = (tail == head);
+            success = true;
+        }
+
+        // A push into a full queue repeats the XOFF: the first one may have been lost
+        if (highWater != 0 && (!success || (!throttled && countLocked() >= highWater))) {
+            throttled = true;
+            flowSignal = FLOW_SIGNAL_XOFF;
+        }
+        return success;
+    }
+
+    size_t countLocked() const {
+        return full ? QUEUE_SIZE : (tail + QUEUE_SIZE - head) % QUEUE_SIZE;
+    }
+
     // Queue status methods - all const
     size_t size() const {
-        if (!initialized || mutex == nullptr) return 0;
-        xSemaphoreTake(mutex, portMAX_DELAY);
-        size_t count = full ? QUEUE_SIZE : (tail + QUEUE_SIZE - head) % QUEUE_SIZE;
-        xSemaphoreGive(mutex);
+        portENTER_CRITICAL(&spin);
+        size_t count = countLocked();
+        portEXIT_CRITICAL(&spin);
         return count;
     }
 
@@ -250,10 +344,9 @@ protected:
     mutable uint32_t lastProcessed = 0;
 
     bool isEmpty() const {
-        if (!initialized || mutex == nullptr) return true;
-        xSemaphoreTake(mutex, portMAX_DELAY);
+        portENTER_CRITICAL(&spin);
         bool empty = (head == tail && !full);
-        xSemaphoreGive(mutex);
+        portEXIT_CRITICAL(&spin);
         return empty;
     }
 };
@@ -266,6 +359,9 @@ public:
         SourceConfig(size_t b = 512, size_t q = 8) : bufferSize(b), queueSize(q) {}
     };
 
+    // Runs on the thread that pushed or popped the packet, outside the queue lock
+    using FlowSignalCallback = std::function<void(EventSourceId sourceId, uint8_t signal)>;
+
     struct Source {
         ThreadSafeQueue queue;
         SourceConfig config;
@@ -292,23 +388,78 @@ public:
         }
     };
 
-    uint8_t createSource(size_t bufferSize = 512, size_t queueSize = 8) {
-        uint8_t sourceId = nextSourceId++;
+    EventSourceId createSource(size_t bufferSize = 512, size_t queueSize = 8) {
+        EventSourceId sourceId = allocateId();
+        if (sourceId == 0) {
+            DEBUG_PRINT("createSource: no free source IDs");
+            return 0;
+        }
         sources[sourceId] = Source(SourceConfig(bufferSize, queueSize));
+        sources[sourceId].queue.setWatermarks(highWater, lowWater);
         DEBUG_PRINT("Created source ID %d with buffer size %d and queue size %d", 
                    sourceId, bufferSize, queueSize);
         return sourceId;
     }
 
-    bool pushToSource(uint8_t sourceId, const uint8_t* data, size_t len) const {
+    // Claim an ID for a source fed straight into EventMsg::process, without a queue
+    EventSourceId reserveSourceId() {
+        EventSourceId sourceId = allocateId();
+        if (sourceId != 0) {
+            reserved.insert(sourceId);
+        }
+        return sourceId;
+    }
+
+    void removeSource(EventSourceId sourceId) {
+        sources.erase(sourceId);
+        reserved.erase(sourceId);
+    }
+
+    bool pushToSource(EventSourceId sourceId, const uint8_t* data, size_t len) const {
         auto it = sources.find(sourceId);
         if (it == sources.end()) {
             DEBUG_PRINT("pushToSource: Source ID %d not found", sourceId);
             return false;
         }
-        return it->second.queue.push(data, len, sourceId);
+        bool pushed = it->second.queue.push(data, len, sourceId);
+        if (flowCallback) {
+            signalFlow(sourceId, it->second.queue);
+        }
+        if (pushed && notifyTask != nullptr) {
+            xTaskNotifyGive(notifyTask);
+        }
+        return pushed;
+    }
+
+    // pushToSource for interrupt handlers: never blocks and takes no mutex.
+    // Flow signals raised here are sent on the next processAll(). Create and
+    // remove sources before the ISR is armed; the lookup is not guarded.
+    bool pushToSourceFromISR(EventSourceId sourceId, const uint8_t* data, size_t len,
+                             BaseType_t* higherPriorityTaskWoken = nullptr) const {
+        auto it = sources.find(sourceId);
+        if (it == sources.end()) return false;
+        bool pushed = it->second.queue.pushFromISR(data, len, sourceId);
+        if (pushed && notifyTask != nullptr) {
+            vTaskNotifyGiveFromISR(notifyTask, higherPriorityTaskWoken);
+        }
+        return pushed;
+    }
+
+    // Task notified on every successful push, e.g. the one calling
+    // processAllSources(); wait with ulTaskNotifyTake()
+    void setNotifyTask(TaskHandle_t task) { notifyTask = task; }
+
+    // Watermarks for every queue, current and future (see ThreadSafeQueue)
+    void setWatermarks(size_t high, size_t low) {
+        highWater = high;
+        lowWater = low;
+        for (auto it = sources.begin(); it != sources.end(); ++it) {
+            it->second.queue.setWatermarks(high, low);
+        }
     }
 
+    void onFlowSignal(FlowSignalCallback cb) { flowCallback = cb; }
+
     template<typename ProcessFunc>
     void processAll(ProcessFunc&& func) const {
         // If no sources, return early
@@ -319,17 +470,20 @@ public:
         
         // Avoid using structured bindings (C++17 feature)
         for(auto it = sources.begin(); it != sources.end(); ++it) {
-            uint8_t sourceId = it->first;
+            EventSourceId sourceId = it->first;
             const Source& source = it->second;
             
             RawPacket packet;
             while(source.queue.tryPop(packet)) {
+                if (flowCallback) {
+                    signalFlow(sourceId, source.queue);
+                }
                 func(sourceId, packet.data, packet.length);
             }
         }
     }
 
-    bool hasSource(uint8_t sourceId) const {
+    bool hasSource(EventSourceId sourceId) const {
         return sources.find(sourceId) != sources.end();
     }
     
@@ -338,11 +492,36 @@ public:
     }
 
 private:
-    mutable std::map<uint8_t, Source> sources;
-    uint8_t nextSourceId = 1;
+    void signalFlow(EventSourceId sourceId, const ThreadSafeQueue& queue) const {
+        uint8_t signal = queue.takeFlowSignal();
+        if (signal != FLOW_SIGNAL_NONE) {
+            flowCallback(sourceId, signal);
+        }
+    }
+
+    EventSourceId allocateId() {
+        // IDs wrap around; skip 0 and any ID still in use
+        for (uint32_t tries = 0; tries < 0xFFFF; tries++) {
+            EventSourceId sourceId = nextSourceId++;
+            if (nextSourceId == 0) nextSourceId = 1;
+            if (sources.find(sourceId) == sources.end() && reserved.find(sourceId) == reserved.end()) {
+                return sourceId;
+            }
+        }
+        return 0;
+    }
+
+    mutable std::map<EventSourceId, Source> sources;
+    std::set<EventSourceId> reserved;
+    EventSourceId nextSourceId = 1;
+    size_t highWater = 0;
+    size_t lowWater = 0;
+    FlowSignalCallback flowCallback;
+    TaskHandle_t notifyTask = nullptr;
 };
 
-// Global source queue manager - avoid inline (C++17 feature)
+// Default source queue manager, shared by every EventMsg not given its own
+// (avoid inline, a C++17 feature)
 extern SourceQueueManager sourceManager;
 
 struct EventHeader {
@@ -350,6 +529,7 @@ struct EventHeader {
     uint8_t receiverId;
     uint8_t groupId;
     uint8_t flags;
+    uint16_t msgId = 0;   // Filled in on receive; assigned by send() unless EVENT_FLAG_RESPONSE
 };
 
 // Protocol Control Characters
@@ -363,6 +543,20 @@ struct EventHeader {
 #define MAX_HEADER_SIZE    6      // Fixed header size (sender,receiver,group,flags,msgid)
 #define MAX_EVENT_NAME_SIZE 32    // Maximum raw event name length
 #define MAX_EVENT_DATA_SIZE 2048  // Maximum raw event data length
+#define MAX_LOCAL_DELIVERY_DEPTH 4  // Nested local sends before the wire is used instead
+
+// Header flag bits
+#define EVENT_FLAG_CRC_MASK 0x03  // Integrity trailer selector
+#define EVENT_FLAG_CRC16    0x01  // 2-byte CRC-16 trailer before EOT
+#define EVENT_FLAG_CRC32    0x02  // 4-byte CRC-32 trailer before EOT
+#define EVENT_CRC_MAX_SIZE  4     // Largest trailer (raw bytes)
+#define EVENT_FLAG_RELIABLE 0x04  // msgId is a ReliableChannel sequence number
+#define EVENT_FLAG_RESPONSE 0x08  // msgId echoes the request being answered
+#define EVENT_FLAG_COMPRESSED 0x10  // Event data is EventLzss-compressed
+#define EVENT_FLAG_COMPACT_ID 0x20  // Name field holds an EventNames ID
+#define EVENT_FLAG_HOPS_MASK  0xC0  // Times a gateway has forwarded the frame
+#define EVENT_FLAG_HOPS_SHIFT 6
+#define EVENT_MAX_HOPS        3     // Frames at this count are not forwarded again
 
 // Broadcast definitions
 #define BROADCAST_ADDR 0xFF    // For both receiver and group
@@ -375,6 +569,14 @@ using WriteCallback = std::function<bool(uint8_t*, size_t)>;
 using EventDispatcherCallback = std::function<void(const char* deviceName, const char* eventName, const char* data, size_t length, EventHeader& header)>;
 // Function type for raw data handling (simplified)
 using RawDataCallback = std::function<void(const char* deviceName, const uint8_t* data, size_t length)>;
+// Capture tap directions
+#define EVENT_CAPTURE_RX 0  // Bytes handed to process(), as received
+#define EVENT_CAPTURE_TX 1  // Frames a transport accepted; sourceId 0 = setWriteCallback transport
+
+// Function type for the raw traffic tap
+using CaptureTapCallback = std::function<void(uint8_t direction, EventSourceId sourceId, const uint8_t* data, size_t length)>;
+// Function type for receive filters, run before dispatch; return false to consume the frame
+using ReceiveFilterCallback = std::function<bool(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header)>;
 
 // Handler structures now using EventHeader internally
 struct RawDataHandler {
@@ -393,26 +595,58 @@ struct EventDispatcherInfo {
     uint8_t groupId;     // FF = accept broadcast groups
 };
 
+struct ReceiveFilter {
+    std::string name;
+    ReceiveFilterCallback callback;
+};
+
+class EventNames;
+
 class EventMsg {
 public:
-    uint8_t createSource(size_t bufferSize = 512, size_t queueSize = 8) {
-        uint8_t sourceId = sourceManager.createSource(bufferSize, queueSize);
+    EventSourceId createSource(size_t bufferSize = 512, size_t queueSize = 8) {
+        EventSourceId sourceId = sourceQueues->createSource(bufferSize, queueSize);
         // Initialize state for this source
-        resetState(sourceId);
+        if (sourceId != 0) resetState(sourceId);
+        return sourceId;
+    }
+
+    // Source without a queue, for transports that call process() themselves
+    EventSourceId createDirectSource() {
+        EventSourceId sourceId = sourceQueues->reserveSourceId();
+        if (sourceId != 0) resetState(sourceId);
         return sourceId;
     }
+
+    // Queues behind createSource() and processAllSources(): the global
+    // sourceManager unless one was passed to the constructor
+    SourceQueueManager& getSourceManager() const { return *sourceQueues; }
+
+    // Drop a source's queue, parser state, transport and learned routes
+    void removeSource(EventSourceId sourceId);
     
     // Create a default source if none exists
     void ensureDefaultSource() {
-        if (sourceManager.getSourceCount() == 0) {
+        if (sourceQueues->getSourceCount() == 0) {
             DEBUG_PRINT("Creating default source");
             createSource(256, 8);  // Default size
         }
     }
 
-    void setWriteCallback(WriteCallback cb) {
-        writeCallback = cb;
-    }
+    void setWriteCallback(WriteCallback cb);
+
+    // Per-source transports: once a peer has been heard on a source, frames
+    // addressed to it go out on that source's transport only
+    void setSourceTransport(EventSourceId sourceId, WriteCallback cb);
+    void removeSourceTransport(EventSourceId sourceId);
+    bool hasSourceTransport(EventSourceId sourceId) const;
+
+    // Hold writes to a link whose peer asked us to stop (see FlowControl).
+    // sourceId 0 is the setWriteCallback transport. The pause lapses on its
+    // own after `ms`; sends routed only to paused links return 0.
+    void pauseTransport(EventSourceId sourceId, uint32_t ms);
+    void resumeTransport(EventSourceId sourceId);
+    bool isTransportPaused(EventSourceId sourceId);
 
 private:
     // Message assembly state machine
@@ -435,44 +669,78 @@ private:
         uint8_t* currentBuffer = nullptr;
         size_t bufferPos = 0;
         bool escapedMode = false;
+        uint8_t crcMode = 0;    // EVENT_FLAG_CRC* bits of the frame being read
+        uint32_t crc = 0;       // Running CRC register, fed byte by byte
+        // Decompressed payload; sized once, on the first compressed frame
+        PSRAMVector<uint8_t> inflateBuffer;
 
         ProcessingState() {
             headerBuffer.reserve(MAX_HEADER_SIZE);
             eventNameBuffer.reserve(MAX_EVENT_NAME_SIZE);
-            eventDataBuffer.reserve(MAX_EVENT_DATA_SIZE);
+            eventDataBuffer.reserve(MAX_EVENT_DATA_SIZE + EVENT_CRC_MAX_SIZE + 1);
         }
     };
 
+    SourceQueueManager* sourceQueues;
+
     // Configuration
     uint8_t localAddr;
     uint8_t groupAddr;
-    uint16_t msgIdCounter;
+    std::atomic<uint16_t> msgIdCounter;
+    uint8_t crcMode;
+    bool crcRequired;
+    size_t compressThreshold;
+    uint32_t crcErrors;
+    // Serializes transport writes and guards the transport tables, so any
+    // task may send. Recursive: a transport may itself send.
+    SemaphoreHandle_t txLock;
     WriteCallback writeCallback;
-    PSRAMVector<EventDispatcherInfo> dispatchers;
-    PSRAMVector<RawDataHandler> rawHandlers;
-    EventDispatcherInfo* unhandledHandler;
+    std::map<EventSourceId, WriteCallback> sourceTransports;
+    std::map<EventSourceId, uint32_t> pausedUntil;  // millis() deadline per paused link
+    EventSourceId routes[256];  // senderId -> sourceId it was last heard on, 0 = unknown
+    bool routeLearning;
+    bool localDelivery;
+    // Everything a received frame is matched against. Published
+    // copy-on-write, so dispatch reads it without a lock while other tasks
+    // (or the handlers themselves) register and unregister.
+    struct HandlerTable {
+        PSRAMVector<EventDispatcherInfo> dispatchers;
+        PSRAMVector<RawDataHandler> rawHandlers;
+        PSRAMVector<ReceiveFilter> receiveFilters;
+        EventDispatcherInfo unhandled{};  // No callback = none set
+    };
+    RcuPtr<HandlerTable> handlers;
+    CaptureTapCallback captureTap;
+    EventNames* nameTable;
 
     // Dynamic state machine per source
-    std::map<uint8_t, ProcessingState> sourceStates;
+    std::map<EventSourceId, ProcessingState> sourceStates;
 
     // Internal methods
-    bool processNextByte(uint8_t sourceId, uint8_t byte);
+    bool processNextByte(EventSourceId sourceId, uint8_t byte);
     void processCallbacks(const char* eventName, const uint8_t* data, size_t dataLength, EventHeader& header);
-    void resetState(uint8_t sourceId);
-    size_t ByteStuff(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen);
-    size_t ByteUnstuff(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen);
+    bool runReceiveFilters(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header);
+    void resetState(EventSourceId sourceId);
     size_t StringToBytes(const char* str, uint8_t* output, size_t outputMaxLen);
+    void crcUpdate(ProcessingState& state, uint8_t byte);
+    bool transmit(EventSourceId sourceId, const WriteCallback& transport, const uint8_t* frame, size_t length);
 
 public:
-    EventMsg() : localAddr(0), groupAddr(0), msgIdCounter(0), unhandledHandler(nullptr) {
-        // No need to initialize fixed array - dynamic map will handle this
+    EventMsg() : EventMsg(sourceManager) {}
+
+    // Own source queues, e.g. one manager per core so independent stacks
+    // never drain each other's sources
+    explicit EventMsg(SourceQueueManager& sources)
+        : sourceQueues(&sources), localAddr(0), groupAddr(0), msgIdCounter(0), crcMode(0),
+          crcRequired(false), compressThreshold(0), crcErrors(0), routeLearning(true), localDelivery(false), nameTable(nullptr) {
+        txLock = xSemaphoreCreateRecursiveMutex();
+        clearRoutes();
     }
     
     ~EventMsg() {
-        // Clean up unhandled handler
-        if (unhandledHandler != nullptr) {
-            delete unhandledHandler;
-            unhandledHandler = nullptr;
+        if (txLock != nullptr) {
+            vSemaphoreDelete(txLock);
+            txLock = nullptr;
         }
     }
     
@@ -488,6 +756,22 @@ public:
     bool init(WriteCallback cb);
     void setAddr(uint8_t addr);
     void setGroup(uint8_t addr);
+    uint8_t getAddr() const { return localAddr; }
+    uint8_t getGroup() const { return groupAddr; }
+
+    // Integrity trailer: mode is EVENT_FLAG_CRC16, EVENT_FLAG_CRC32 or 0.
+    // Applied to every send whose header does not select a CRC itself.
+    void setCrcMode(uint8_t mode) { crcMode = mode & EVENT_FLAG_CRC_MASK; }
+    uint8_t getCrcMode() const { return crcMode; }
+    // Drop incoming frames that carry no CRC trailer
+    void setCrcRequired(bool required) { crcRequired = required; }
+    uint32_t getCrcErrorCount() const { return crcErrors; }
+
+    // Compress payloads of at least `threshold` bytes (0 = off). A header
+    // with EVENT_FLAG_COMPRESSED asks for it on one send regardless. Either
+    // way the payload goes out as is unless compressing makes it smaller.
+    void setCompression(size_t threshold) { compressThreshold = threshold; }
+    size_t getCompression() const { return compressThreshold; }
     bool isHandlerMatch(const EventHeader& header, uint8_t receiverId, uint8_t senderId, uint8_t groupId);
 
     void processAllSources();
@@ -495,8 +779,57 @@ public:
     size_t send(const char* name, const char* data, const EventHeader& header);
     size_t send(const char* name, const char* data, uint8_t receiverId, uint8_t groupId, uint8_t senderId);
     size_t send(const char* name, const char* data, uint8_t receiverId, uint8_t groupId);
-    bool process(uint8_t sourceId, const uint8_t* data, size_t len);
+    // Binary payload, may contain zero bytes
+    size_t send(const char* name, const uint8_t* data, size_t length, const EventHeader& header);
+    bool process(EventSourceId sourceId, const uint8_t* data, size_t len);
+    // Explicit multicast to the given sources, ignoring the routing table
+    size_t multicast(const EventSourceId* sourceIds, size_t count, const char* name,
+                     const uint8_t* data, size_t length, const EventHeader& header);
+
+    // Return-path routing table, learned from the senderId of incoming frames
+    void setRouteLearning(bool enabled) { routeLearning = enabled; }
+    void learnRoute(uint8_t addr, EventSourceId sourceId) { routes[addr] = sourceId; }
+    EventSourceId getRoute(uint8_t addr) const { return routes[addr]; }
+    void forgetRoute(uint8_t addr) { routes[addr] = 0; }
+    void forgetRoutesVia(EventSourceId sourceId);
+    void clearRoutes() { memset(routes, 0, sizeof(routes)); }
+
+    // Local delivery: send() hands events addressed to this node (receiverId
+    // == getAddr()) or to its group (receiverId BROADCAST_ADDR, groupId ==
+    // getGroup()) straight to the handlers, without framing or a transport,
+    // on the sending task. A group send still goes out to the other members;
+    // one addressed to this node alone never touches the wire. Plain
+    // broadcasts are not looped back. Receive filters and the capture tap do
+    // not see local deliveries. Handlers get a NUL-terminated copy of the
+    // payload, as from the parser. A handler may send to this node again;
+    // past MAX_LOCAL_DELIVERY_DEPTH nested sends on one task, the event is
+    // encoded and written as if local delivery were off.
+    void setLocalDelivery(bool enabled) { localDelivery = enabled; }
+    bool getLocalDelivery() const { return localDelivery; }
+    // What send() does with the event when local delivery is on. Returns
+    // true if that was all: the header addresses no one but this node.
+    bool deliverLocal(const char* name, const uint8_t* data, size_t length, const EventHeader& header, uint16_t msgId);
+
+    // Byte stuffing as used on the wire; return 0 if the output is too small
+    static size_t ByteStuff(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen);
+    static size_t ByteUnstuff(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen);
+
+    // Frame-level access for protocol layers built on top of send()
+    uint16_t nextMsgId();
+    size_t encodeFrame(const char* name, const uint8_t* data, size_t length,
+                       const EventHeader& header, uint16_t msgId, PSRAMVector<uint8_t>& frame);
+    // Route by receiverId: known peer -> its source only, otherwise every transport
+    bool writeFrame(const uint8_t* frame, size_t length, uint8_t receiverId = BROADCAST_ADDR);
+    // sourceId 0 is the setWriteCallback transport. Urgent frames (flow
+    // control) are written even while the link is paused.
+    bool writeFrameTo(EventSourceId sourceId, const uint8_t* frame, size_t length, bool urgent = false);
+    // Hand a frame to the handlers as if it had just been parsed
+    void deliver(const char* eventName, const uint8_t* data, size_t length, EventHeader& header);
     
+    // Handler registration is safe from any task, and from inside a handler,
+    // while frames are being dispatched. A change applies from the next
+    // frame; one already being dispatched finishes with the old handlers.
+
     // Event registration with simplified parameters
     bool registerRawHandler(const char* deviceName, const EventHeader& header, RawDataCallback cb);
     bool unregisterRawHandler(const char* deviceName);
@@ -505,6 +838,55 @@ public:
     // Dispatcher registration with simplified parameters
     bool registerDispatcher(const char* deviceName, const EventHeader& header, EventDispatcherCallback cb);
     bool unregisterDispatcher(const char* deviceName);
+
+    // Dictionary for EVENT_FLAG_COMPACT_ID frames; set by EventNames::begin()
+    void setNameTable(EventNames* table) { nameTable = table; }
+    EventNames* getNameTable() const { return nameTable; }
+
+    // See every byte received and every frame sent, e.g. for EventCapture.
+    // Runs on the thread calling process() or send().
+    void setCaptureTap(CaptureTapCallback cb) { captureTap = cb; }
+
+    // Receive filters run in registration order once a frame is complete
+    bool registerReceiveFilter(const char* name, ReceiveFilterCallback cb);
+    bool unregisterReceiveFilter(const char* name);
+};
+
+// An event sent over and over with the same name and header.
+//
+// The SOH, sender/receiver/group/flags bytes, STX, name and US are stuffed
+// once, here. send() copies them, stuffs only the two msgId bytes and the
+// payload, and writes the frame like EventMsg::send(). The CRC register is
+// primed with the fixed header bytes too, so per-send work is the payload
+// plus a constant. The instance CRC mode and EventNames ID are taken when
+// prepared; prepare() again after setCrcMode(). Payloads are never
+// compressed. send() is safe from any task.
+class PreparedEvent {
+public:
+    PreparedEvent(EventMsg& eventMsg, const char* name, const EventHeader& header);
+
+    // Re-target at a new name or header; false if they cannot be encoded
+    bool prepare(const char* name, const EventHeader& header);
+    bool isValid() const { return !suffix.empty(); }
+    const EventHeader& getHeader() const { return header; }
+
+    // Same results as EventMsg::send() with this name and header
+    size_t send(const uint8_t* data, size_t length) const;
+    size_t send(const char* data) const;
+
+    // The frame send() would write, for transports outside EventMsg
+    size_t encode(const uint8_t* data, size_t length, uint16_t msgId, PSRAMVector<uint8_t>& frame) const;
+
+private:
+    EventMsg& eventMsg;
+    EventHeader header{};
+    uint8_t flags = 0;              // header.flags with the CRC mode applied
+    uint8_t prefix[1 + 4 * 2];      // SOH and the stuffed bytes ahead of msgId
+    size_t prefixLen = 0;
+    PSRAMVector<uint8_t> suffix;    // STX, stuffed name, US
+    PSRAMVector<uint8_t> name;      // Name field as sent (the name or its EventNames ID), for the CRC
+    char localName[MAX_EVENT_NAME_SIZE] = {};  // The name itself, for local delivery
+    uint32_t crcSeed = 0;           // CRC register after the bytes ahead of msgId
 };
 
 #endif // EVENT_MSG_H
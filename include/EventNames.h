@@ -0,0 +1,104 @@
+#ifndef EVENT_NAMES_H
+#define EVENT_NAMES_H
+
+#include "EventMsg.h"
+
+// Dictionary control events
+#define NAMES_DEF_EVENT "_evdef"  // [id:2][name] the sender's ID for name
+#define NAMES_REQ_EVENT "_evreq"  // [id:2] resend the definition of id; empty = all of them
+
+#define NAMES_MAX_ID 0x7FFF
+
+// Numeric event IDs on the wire.
+//
+// Names passed to compact() get an ID from this node. Frames we originate
+// with such a name carry the ID in place of the name and set
+// EVENT_FLAG_COMPACT_ID: one byte for IDs below 0x80, otherwise two
+// (high bit set on the first). The first such frame is preceded by an
+// _evdef broadcast, and announce() repeats every definition, e.g. when a
+// link comes up.
+//
+// Receivers keep a table per sender address. The parser swaps a known ID
+// back for the name before the receive filters run, so dedupe, reliable
+// delivery and every handler see an ordinary named event. A frame with an
+// ID we have not been told about is dropped and answered with an _evreq,
+// at most once per requestInterval per sender, so a lost _evdef or a peer
+// that joined late heals on its own. Both ends need an EventNames begun;
+// frames relayed from other senders are never compacted.
+class EventNames {
+public:
+    struct Config {
+        uint16_t maxIds;           // IDs accepted per sender (and assigned locally)
+        uint16_t requestInterval;  // Minimum ms between _evreq to one sender
+        Config(uint16_t maxIds = 128, uint16_t requestInterval = 500)
+            : maxIds(maxIds > NAMES_MAX_ID + 1 ? NAMES_MAX_ID + 1 : maxIds), requestInterval(requestInterval) {}
+    };
+
+    struct Stats {
+        uint32_t compactSent = 0;    // Frames encoded with an ID
+        uint32_t bytesSaved = 0;     // Name bytes left off those frames (before stuffing)
+        uint32_t definitionsSent = 0;
+        uint32_t definitionsReceived = 0;
+        uint32_t requestsSent = 0;
+        uint32_t unknownDropped = 0; // Frames with an ID we had no name for
+    };
+
+    EventNames(EventMsg& eventMsg, const Config& config = Config());
+    ~EventNames();
+
+    // Register the receive filter and attach to the EventMsg encoder and
+    // parser. Begin this before other layers so their control events can
+    // be compacted too.
+    bool begin(const char* name);
+    void end();
+
+    // Send name as an ID from now on; returns the ID, or NAMES_MAX_ID + 1
+    // if the table is full or the name is invalid. Assign IDs in the order
+    // of how often the events are sent: the first 128 cost one byte.
+    uint16_t compact(const char* name);
+
+    // Broadcast (or send to one peer) the definition of every compact name
+    void announce(uint8_t receiverId = BROADCAST_ADDR);
+
+    // The name a sender uses for id, copied into name; false if unknown
+    bool lookup(uint8_t senderId, uint16_t id, char* name, size_t size) const;
+
+    Stats getStats() const;
+
+    // Called by EventMsg::encodeFrame(): write the ID for name into out
+    // (2 bytes) and return its length, or 0 to send the name as is
+    size_t encode(const char* name, const EventHeader& header, uint8_t* out);
+    // Called by the parser on a compact frame: replace the ID in name with
+    // the NUL-terminated name; false drops the frame
+    bool resolve(const EventHeader& header, PSRAMVector<uint8_t>& name);
+
+private:
+    struct Local {
+        std::string name;
+        bool announced = false;
+    };
+
+    struct Peer {
+        PSRAMVector<std::string> names;  // Indexed by ID; empty = unknown
+        uint32_t lastRequest = 0;
+        bool requested = false;    // lastRequest is set
+    };
+
+    bool onFrame(const char* eventName, const uint8_t* data, size_t length, const EventHeader& header);
+    void sendDefinition(uint16_t id, const std::string& name, uint8_t receiverId);
+    void sendRequest(uint8_t senderId, uint16_t id);
+    size_t findLocked(const char* name) const;  // Position in byName
+
+    EventMsg& eventMsg;
+    Config config;
+    std::string filterName;
+
+    // Taken by senders and the parser; never held while sending
+    SemaphoreHandle_t lock = nullptr;
+    PSRAMVector<Local> locals;     // Indexed by ID
+    PSRAMVector<uint16_t> byName;  // Local IDs sorted by name, for binary search
+    std::map<uint8_t, Peer> peers; // By sender address
+    Stats stats;
+};
+
+#endif // EVENT_NAMES_H
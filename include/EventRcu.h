@@ -0,0 +1,108 @@
+#ifndef EVENT_RCU_H
+#define EVENT_RCU_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <vector>
+
+// Copy-on-write pointer for read-mostly tables such as handler lists.
+//
+// Readers hold a Reader for as long as they use the table: entering and
+// leaving cost one atomic increment and decrement, never a lock, and the
+// table they see does not change or go away underneath them.
+//
+// Writers copy the current table, edit the copy and publish it with an
+// atomic pointer swap. The replaced version is retired and freed once no
+// reader is active: straight away if the table is idle, otherwise by the
+// last reader to leave or by the next update. Writers are serialized by a
+// mutex but never wait for readers, so a callback running under a Reader
+// may itself update the table; it keeps seeing the old version until it
+// leaves.
+template <typename T>
+class RcuPtr {
+public:
+    class Reader {
+    public:
+        explicit Reader(const RcuPtr& owner) : owner(owner) {
+            owner.readers.fetch_add(1);
+            table = owner.current.load();
+        }
+        ~Reader() { owner.leave(); }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        const T& operator*() const { return *table; }
+        const T* operator->() const { return table; }
+
+    private:
+        const RcuPtr& owner;
+        const T* table;
+    };
+
+    RcuPtr() : current(new T()), version(0), readers(0), pending(false) {
+        writeLock = xSemaphoreCreateMutex();
+    }
+
+    ~RcuPtr() {
+        delete current.load();
+        for (T* table : retired) delete table;
+        if (writeLock != nullptr) {
+            vSemaphoreDelete(writeLock);
+        }
+    }
+
+    RcuPtr(const RcuPtr&) = delete;
+    RcuPtr& operator=(const RcuPtr&) = delete;
+
+    // Apply edit to a copy of the table and publish it if edit returns true
+    template <typename Edit>
+    bool update(Edit edit) {
+        xSemaphoreTake(writeLock, portMAX_DELAY);
+        T* next = new T(*current.load());
+        bool changed = edit(*next);
+        if (changed) {
+            retired.push_back(current.exchange(next));
+            version.fetch_add(1);
+            pending.store(true);
+            reclaimLocked();
+        } else {
+            delete next;
+        }
+        xSemaphoreGive(writeLock);
+        return changed;
+    }
+
+    // Bumped on every publish
+    uint32_t getVersion() const { return version.load(); }
+
+private:
+    void leave() const {
+        if (readers.fetch_sub(1) == 1 && pending.load()) {
+            // Never blocks: if a writer holds the lock, its next reclaim
+            // (or the next reader to leave) picks these up instead
+            if (xSemaphoreTake(writeLock, 0) == pdTRUE) {
+                reclaimLocked();
+                xSemaphoreGive(writeLock);
+            }
+        }
+    }
+
+    // Caller holds writeLock. A reader arriving after the swap can only
+    // load the new table, so zero readers here means no one holds a retired one.
+    void reclaimLocked() const {
+        if (readers.load() != 0) return;
+        for (T* table : retired) delete table;
+        retired.clear();
+        pending.store(false);
+    }
+
+    std::atomic<T*> current;
+    std::atomic<uint32_t> version;
+    mutable std::atomic<uint32_t> readers;
+    mutable std::atomic<bool> pending;
+    mutable std::vector<T*> retired;
+    SemaphoreHandle_t writeLock;
+};
+
+#endif // EVENT_RCU_H
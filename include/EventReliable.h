@@ -0,0 +1,129 @@
+#ifndef EVENT_RELIABLE_H
+#define EVENT_RELIABLE_H
+
+#include "EventMsg.h"
+
+// Control events exchanged between the two ends of a channel
+#define RELIABLE_ACK_EVENT    "_ack"     // [cumAck:2][sack bitmap:4]
+#define RELIABLE_NACK_EVENT   "_nack"    // [seq:2] retransmit request
+#define RELIABLE_SYNC_EVENT   "_rsync"   // [seq:2] receiver window starts here
+#define RELIABLE_SYNCREQ_EVENT "_rsreq"  // receiver has no window, please resync
+
+#define RELIABLE_MAX_WINDOW 32  // Bounded by the 32-bit selective ACK bitmap
+
+// Sliding-window reliable delivery to one peer.
+//
+// Data frames carry EVENT_FLAG_RELIABLE and use the header msgId as a
+// per-channel sequence number. The receiver reorders frames in a fixed
+// window and delivers them to the EventMsg handlers in sequence; it answers
+// with cumulative + selective ACKs and NACKs the first gap it sees. The
+// sender keeps up to `window` frames in flight and retransmits on a timer
+// derived from smoothed RTT (RFC 6298, Karn's rule for samples).
+class ReliableChannel {
+public:
+    struct Config {
+        uint8_t window;      // Frames in flight, 1..RELIABLE_MAX_WINDOW
+        uint32_t minRto;     // Retransmit timeout bounds (ms)
+        uint32_t maxRto;
+        uint32_t ackDelay;   // Hold in-order ACKs up to this long (ms), 0 = immediate
+        Config(uint8_t w = 8, uint32_t minR = 50, uint32_t maxR = 3000, uint32_t delay = 0)
+            : window(w), minRto(minR), maxRto(maxR), ackDelay(delay) {}
+    };
+
+    struct Stats {
+        uint32_t sent = 0;
+        uint32_t retransmits = 0;
+        uint32_t delivered = 0;
+        uint32_t duplicates = 0;
+        uint32_t outOfOrder = 0;
+        uint32_t acksSent = 0;
+        uint32_t acksReceived = 0;
+        uint32_t nacksSent = 0;
+        uint32_t nacksReceived = 0;
+    };
+
+    ReliableChannel(EventMsg& eventMsg, uint8_t localAddr, uint8_t peerAddr, const Config& config = Config());
+    ~ReliableChannel();
+
+    // Register the receive filter and start syncing with the peer
+    bool begin(const char* name);
+    void end();
+
+    // Queue a frame for reliable delivery; returns 0 when the window is full
+    size_t send(const char* name, const uint8_t* data, size_t length, const EventHeader& header);
+    size_t send(const char* name, const char* data, const EventHeader& header);
+
+    // Drive retransmit and delayed-ACK timers; call from loop()
+    void update();
+
+    bool canSend() const { return isSynced() && (uint16_t)(sndNxt - sndUna) < config.window; }
+    bool isSynced() const { return txSynced; }
+    size_t inFlight() const { return (uint16_t)(sndNxt - sndUna); }
+    uint32_t getRto() const { return rto; }
+    uint32_t getSrtt() const { return srtt8 / 8; }
+    const Stats& getStats() const { return stats; }
+    uint8_t getPeer() const { return peerAddr; }
+
+private:
+    struct TxSlot {
+        bool used = false;
+        bool acked = false;
+        bool retransmitted = false;
+        uint16_t seq = 0;
+        uint8_t backoff = 0;
+        uint32_t sentAt = 0;
+        PSRAMVector<uint8_t> frame;
+    };
+
+    struct RxSlot {
+        bool used = false;
+        uint16_t seq = 0;
+        EventHeader header{};
+        std::string name;
+        PSRAMVector<uint8_t> data;
+    };
+
+    static bool seqBefore(uint16_t a, uint16_t b) { return (int16_t)(a - b) < 0; }
+
+    bool onFrame(const char* eventName, const uint8_t* data, size_t length, EventHeader& header);
+    void onData(const char* eventName, const uint8_t* data, size_t length, EventHeader& header);
+    void onAck(const uint8_t* data, size_t length);
+    void onNack(const uint8_t* data, size_t length);
+    void onSync(const uint8_t* data, size_t length);
+
+    void sendControl(const char* name, const uint8_t* data, size_t length);
+    void sendAck();
+    void sendSync();
+    void transmit(TxSlot& slot, uint32_t now);
+    void sampleRtt(uint32_t rtt);
+
+    EventMsg& eventMsg;
+    uint8_t localAddr;
+    uint8_t peerAddr;
+    Config config;
+    std::string filterName;
+
+    // Sender
+    TxSlot txSlots[RELIABLE_MAX_WINDOW];
+    uint16_t sndUna = 0;  // Oldest unacknowledged sequence
+    uint16_t sndNxt = 0;  // Next sequence to assign
+    bool txSynced = false;
+    uint32_t syncSentAt = 0;
+    bool rttValid = false;
+    uint32_t srtt8 = 0;   // Smoothed RTT, ms * 8
+    uint32_t rttvar4 = 0; // RTT variance, ms * 4
+    uint32_t rto;
+
+    // Receiver
+    RxSlot rxSlots[RELIABLE_MAX_WINDOW];
+    uint16_t rcvNxt = 0;  // Next in-order sequence expected
+    bool rxSynced = false;
+    bool ackPending = false;
+    uint32_t ackPendingSince = 0;
+    uint16_t lastNack = 0;
+    bool nackValid = false;
+
+    Stats stats;
+};
+
+#endif // EVENT_RELIABLE_H
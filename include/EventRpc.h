@@ -0,0 +1,74 @@
+#ifndef EVENT_RPC_H
+#define EVENT_RPC_H
+
+#include "EventMsg.h"
+
+enum class RpcStatus : uint8_t {
+    OK,         // Response received
+    TIMEOUT,    // Deadline passed without a response
+    CANCELLED   // cancel() or end() before a response arrived
+};
+
+// Completion callback; data/length/header describe the response frame (empty on failure)
+using RpcCallback = std::function<void(RpcStatus status, const char* data, size_t length, EventHeader& header)>;
+
+// Pipelined request/response on top of EventMsg.
+//
+// Each call() is sent with a fresh msgId and parked in a fixed-size pending
+// table until a frame flagged EVENT_FLAG_RESPONSE with the same msgId comes
+// back from the addressed peer, or its deadline passes. Responders echo the
+// msgId by building their reply header with
+// EventDispatcher::createResponseHeader(). Any number of calls up to the
+// table size can be in flight at once over a single link.
+class RpcClient {
+public:
+    struct Stats {
+        uint32_t calls = 0;
+        uint32_t completed = 0;
+        uint32_t timeouts = 0;
+        uint32_t rejected = 0;   // Table full or send failed
+    };
+
+    RpcClient(EventMsg& eventMsg, size_t maxPending = 16);
+    ~RpcClient();
+
+    // Register the response filter
+    bool begin(const char* name);
+    // Unregister and cancel everything still pending
+    void end();
+
+    // Returns the request msgId, or -1 if the table is full or the send failed
+    int32_t call(const char* event, const char* payload, const EventHeader& header,
+                 uint32_t timeoutMs, RpcCallback cb);
+    int32_t call(const char* event, const uint8_t* payload, size_t length, const EventHeader& header,
+                 uint32_t timeoutMs, RpcCallback cb);
+
+    bool cancel(uint16_t msgId);
+
+    // Expire calls whose deadline has passed; call from loop()
+    void update();
+
+    size_t pending() const { return pendingCount; }
+    size_t capacity() const { return calls.size(); }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct PendingCall {
+        bool used = false;
+        uint16_t msgId = 0;
+        uint8_t peer = 0;
+        uint32_t deadline = 0;
+        RpcCallback callback;
+    };
+
+    bool onFrame(const char* eventName, const uint8_t* data, size_t length, EventHeader& header);
+    void complete(PendingCall& call, RpcStatus status, const char* data, size_t length, EventHeader& header);
+
+    EventMsg& eventMsg;
+    PSRAMVector<PendingCall> calls;
+    size_t pendingCount = 0;
+    std::string filterName;
+    Stats stats;
+};
+
+#endif // EVENT_RPC_H
@@ -0,0 +1,66 @@
+#ifndef EVENT_SLAB_H
+#define EVENT_SLAB_H
+
+#include "EventMsg.h"
+
+// Fixed-capacity object pool.
+//
+// Every slot is allocated once, up front (in PSRAM when available), and
+// recycled through an index free list, so connect/disconnect churn never
+// touches the heap. Freed slots keep their contents, including any buffer
+// capacity, for the next owner. Not thread-safe; callers lock.
+template <typename T>
+class EventSlab {
+public:
+    static const uint16_t NONE = 0xFFFF;
+
+    explicit EventSlab(size_t capacity)
+        : slots(capacity < NONE ? capacity : NONE - 1), next(slots.size()), used(slots.size(), 0) {
+        for (size_t i = 0; i < slots.size(); i++) {
+            next[i] = (i + 1 < slots.size()) ? (uint16_t)(i + 1) : NONE;
+        }
+        freeHead = slots.empty() ? NONE : 0;
+    }
+
+    // Returns the slot index, or NONE when full
+    uint16_t alloc() {
+        uint16_t index = freeHead;
+        if (index == NONE) return NONE;
+        freeHead = next[index];
+        used[index] = 1;
+        count++;
+        return index;
+    }
+
+    void free(uint16_t index) {
+        if (index >= slots.size() || !used[index]) return;
+        used[index] = 0;
+        next[index] = freeHead;
+        freeHead = index;
+        count--;
+    }
+
+    T& operator[](uint16_t index) { return slots[index]; }
+    const T& operator[](uint16_t index) const { return slots[index]; }
+    bool isUsed(uint16_t index) const { return index < slots.size() && used[index]; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    bool full() const { return freeHead == NONE; }
+
+    template <typename Func>
+    void forEach(Func&& func) {
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (used[i]) func((uint16_t)i, slots[i]);
+        }
+    }
+
+private:
+    PSRAMVector<T> slots;
+    PSRAMVector<uint16_t> next;
+    PSRAMVector<uint8_t> used;
+    uint16_t freeHead = NONE;
+    size_t count = 0;
+};
+
+#endif // EVENT_SLAB_H
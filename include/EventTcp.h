@@ -0,0 +1,145 @@
+#ifndef EVENT_TCP_H
+#define EVENT_TCP_H
+
+#include "EventMsg.h"
+#include "EventSlab.h"
+#include <atomic>
+
+// Backends: sockets on the FdTransport reactor on Linux hosts, AsyncTCP on ESP32
+#if defined(__linux__) && !defined(ARDUINO)
+#include "EventFdTransport.h"
+#define EVENT_TCP_HOST 1
+#elif defined(ESP32) && __has_include(<AsyncTCP.h>)
+#include <AsyncTCP.h>
+#define EVENT_TCP_ASYNC 1
+#endif
+
+#if EVENT_TCP_HOST || EVENT_TCP_ASYNC
+#define EVENT_TCP_AVAILABLE 1
+
+#if EVENT_TCP_HOST
+#include <mutex>
+#endif
+
+using TcpConnectionCallback = std::function<void(EventSourceId sourceId)>;
+
+#if EVENT_TCP_ASYNC
+// Per-connection state on ESP32. Slots, their sources and their transmit
+// buffers are set up once in begin() and reused across connections.
+struct TcpConnection {
+    AsyncClient* client = nullptr;
+    EventSourceId sourceId = 0;
+    uint32_t connectedAt = 0;
+    PSRAMVector<uint8_t> tx;   // Bytes AsyncTCP had no room for yet
+    size_t txLen = 0;
+};
+#endif
+
+// TCP server: each accepted connection becomes its own source with its own
+// transport, so replies follow the route back to the client they answer
+// and broadcasts fan out to every client.
+//
+// Connection state lives in a fixed-size slab; clients beyond maxClients
+// are refused at accept. On Linux hosts the sockets are served by an
+// FdTransport reactor, which handlers run on. On ESP32, AsyncTCP delivers
+// data into the source queues and processAllSources() parses it as usual.
+class TcpServer {
+public:
+    // Updated on the reactor (AsyncTCP) task, read from any
+    struct Stats {
+        std::atomic<uint32_t> accepted{0};
+        std::atomic<uint32_t> rejected{0};      // Refused: slab full or no free source ID
+        std::atomic<uint32_t> disconnected{0};
+    };
+
+#if EVENT_TCP_HOST
+    TcpServer(FdTransport& fds, uint16_t port, size_t maxClients = 1024);
+#else
+    TcpServer(EventMsg& eventMsg, uint16_t port, size_t maxClients = 8, size_t txBufferSize = 2048);
+#endif
+    ~TcpServer();
+
+    bool begin();
+    void end();
+
+    // Close one client; its disconnect callback runs once it is gone
+    bool disconnect(EventSourceId sourceId);
+
+    void onConnect(TcpConnectionCallback cb) { connectCallback = cb; }
+    void onDisconnect(TcpConnectionCallback cb) { disconnectCallback = cb; }
+
+    uint16_t getPort() const { return port; }  // Actual port once begun, if 0 was asked for
+    size_t clientCount() const;
+    size_t capacity() const { return clients.capacity(); }
+    const Stats& getStats() const { return stats; }
+
+private:
+#if EVENT_TCP_HOST
+    struct Client {
+        EventSourceId sourceId = 0;
+        uint32_t connectedAt = 0;
+    };
+
+    void accept(int fd);
+    void closed(uint16_t index, EventSourceId sourceId);
+
+    FdTransport& fds;
+    int listenFd = -1;
+    mutable std::mutex lock;
+    EventSlab<Client> clients;
+#else
+    static void handleClient(void* arg, AsyncClient* client);
+    void accept(AsyncClient* client);
+    void closed(uint16_t index);
+
+    EventMsg& eventMsg;
+    AsyncServer* server = nullptr;
+    SemaphoreHandle_t lock = nullptr;
+    EventSlab<TcpConnection> clients;
+    size_t txBufferSize;
+#endif
+    uint16_t port;
+    TcpConnectionCallback connectCallback;
+    TcpConnectionCallback disconnectCallback;
+    Stats stats;
+};
+
+// TCP client: one outgoing connection mapped to one source
+class TcpClient {
+public:
+#if EVENT_TCP_HOST
+    explicit TcpClient(FdTransport& fds);
+#else
+    explicit TcpClient(EventMsg& eventMsg, size_t txBufferSize = 2048);
+#endif
+    ~TcpClient();
+
+    // Host: blocks until connected, and may be called from any thread while
+    // the reactor runs. ESP32: starts connecting; the connect callback runs
+    // once the link is up. Returns false if it can't start.
+    bool connect(const char* host, uint16_t port);
+    void disconnect();
+
+    bool isConnected() const { return connected; }
+    EventSourceId getSourceId() const { return sourceId; }
+
+    void onConnect(TcpConnectionCallback cb) { connectCallback = cb; }
+    void onDisconnect(TcpConnectionCallback cb) { disconnectCallback = cb; }
+
+private:
+#if EVENT_TCP_HOST
+    FdTransport& fds;
+#else
+    EventMsg& eventMsg;
+    SemaphoreHandle_t lock = nullptr;
+    TcpConnection conn;
+#endif
+    EventSourceId sourceId = 0;
+    std::atomic<bool> connected{false};
+    TcpConnectionCallback connectCallback;
+    TcpConnectionCallback disconnectCallback;
+};
+
+#endif // EVENT_TCP_AVAILABLE
+
+#endif // EVENT_TCP_H
@@ -0,0 +1,78 @@
+#ifndef EVENT_TOPIC_H
+#define EVENT_TOPIC_H
+
+#include "EventMsg.h"
+#include <string.h>
+
+// Trie of hierarchical topic patterns for EventDispatcher subscriptions.
+//
+// Event names are split into levels on '/'. In a pattern, a level of "*"
+// matches exactly one level and a final "#" matches zero or more levels,
+// so "sensor/#" is a prefix subscription covering "sensor" and everything
+// under it; any other level, and any name without wildcards, matches
+// literally. Patterns are compiled into the trie when registered. match()
+// walks one level at a time, so its cost depends on the name and on how
+// many wildcard branches apply, not on how many patterns are registered.
+class TopicTrie {
+public:
+    static const uint32_t NONE = 0xFFFFFFFF;
+
+    TopicTrie() { nodes.resize(1); }
+
+    // Attach id to pattern; an id may be attached to several patterns
+    void insert(const char* pattern, uint16_t id);
+    // Detach id from pattern; returns false if it was not attached
+    bool remove(const char* pattern, uint16_t id);
+
+    bool empty() const { return patterns == 0; }
+    size_t size() const { return patterns; }
+
+    // Call fn(id) for every pattern matching name
+    template <typename Fn>
+    void match(const char* name, Fn&& fn) const {
+        if (patterns == 0) return;
+        collect(0, name, false, fn);
+    }
+
+private:
+    struct Edge {
+        std::string token;
+        uint32_t node;
+    };
+
+    struct Node {
+        PSRAMVector<Edge> children;  // Literal levels, sorted by token
+        uint32_t any = NONE;         // "*" child
+        uint32_t rest = NONE;        // "#" child, always a leaf
+        PSRAMVector<uint16_t> ids;   // Patterns ending here
+    };
+
+    template <typename Fn>
+    void collect(uint32_t index, const char* level, bool atEnd, Fn& fn) const {
+        const Node& node = nodes[index];
+        if (node.rest != NONE) {
+            for (uint16_t id : nodes[node.rest].ids) fn(id);
+        }
+        if (atEnd) {
+            for (uint16_t id : node.ids) fn(id);
+            return;
+        }
+
+        const char* end = strchr(level, '/');
+        bool last = (end == nullptr);
+        if (last) end = level + strlen(level);
+        const char* next = last ? end : end + 1;
+
+        uint32_t child = findChild(node, level, (size_t)(end - level));
+        if (child != NONE) collect(child, next, last, fn);
+        if (node.any != NONE) collect(node.any, next, last, fn);
+    }
+
+    uint32_t findChild(const Node& node, const char* token, size_t length) const;
+    uint32_t walk(const char* pattern, bool create);
+
+    PSRAMVector<Node> nodes;  // nodes[0] is the root
+    size_t patterns = 0;
+};
+
+#endif // EVENT_TOPIC_H
@@ -0,0 +1,61 @@
+#ifndef EVENT_TYPED_H
+#define EVENT_TYPED_H
+
+#include "EventMsg.h"
+#include <type_traits>
+
+// Binary payloads with a compile-time layout.
+//
+// Declare the payload as a packed struct of fixed-width fields:
+//
+//   struct EVENT_PACKED Telemetry {
+//       float temperature;
+//       uint16_t batteryMv;
+//       int8_t rssi;
+//   };
+//
+// On the wire it is the struct's bytes, little-endian, with no padding.
+// Both supported targets (ESP32, x86/ARM hosts) are little-endian, so
+// encoding is a copy into the send buffer. On receive, the handler gets a
+// const reference straight into the parser's buffer, with no decode step.
+// A payload shorter than the struct is dropped. A longer one is accepted,
+// so new fields can be appended without breaking older receivers.
+#define EVENT_PACKED __attribute__((packed))
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "typed payloads are little-endian on the wire; this target would need byte swapping");
+
+template <typename T>
+struct EventPayload {
+    static_assert(std::is_trivially_copyable<T>::value, "payload structs must be plain data");
+    static_assert(alignof(T) == 1, "declare payload structs EVENT_PACKED so they can be viewed in place");
+
+    // The payload as a T, or nullptr if it is too short
+    static const T* view(const char* data, size_t length) {
+        return length >= sizeof(T) ? reinterpret_cast<const T*>(data) : nullptr;
+    }
+
+    static const uint8_t* bytes(const T& payload) {
+        return reinterpret_cast<const uint8_t*>(&payload);
+    }
+};
+
+// A PreparedEvent whose payload is a T
+template <typename T>
+class TypedEvent {
+public:
+    TypedEvent(EventMsg& eventMsg, const char* name, const EventHeader& header)
+        : prepared(eventMsg, name, header) {}
+
+    bool isValid() const { return prepared.isValid(); }
+    PreparedEvent& getPrepared() { return prepared; }
+
+    size_t send(const T& payload) const {
+        return prepared.send(EventPayload<T>::bytes(payload), sizeof(T));
+    }
+
+private:
+    PreparedEvent prepared;
+};
+
+#endif // EVENT_TYPED_H
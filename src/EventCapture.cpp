@@ -0,0 +1,281 @@
+#include "EventCapture.h"
+#include <string.h>
+
+static void putHeader(uint8_t* out, uint32_t ts, EventSourceId sourceId, uint8_t direction, uint16_t length) {
+    out[0] = (uint8_t)ts;
+    out[1] = (uint8_t)(ts >> 8);
+    out[2] = (uint8_t)(ts >> 16);
+    out[3] = (uint8_t)(ts >> 24);
+    out[4] = (uint8_t)sourceId;
+    out[5] = (uint8_t)(sourceId >> 8);
+    out[6] = direction;
+    out[7] = (uint8_t)length;
+    out[8] = (uint8_t)(length >> 8);
+}
+
+static void putFileHeader(uint8_t* out) {
+    memcpy(out, CAPTURE_MAGIC, 4);
+    out[4] = CAPTURE_VERSION;
+    out[5] = out[6] = out[7] = 0;
+}
+
+static bool checkFileHeader(const uint8_t* in) {
+    return memcmp(in, CAPTURE_MAGIC, 4) == 0 && in[4] == CAPTURE_VERSION;
+}
+
+EventCapture::EventCapture(size_t ringBytes) : ring(ringBytes) {
+    lock = xSemaphoreCreateMutex();
+}
+
+EventCapture::~EventCapture() {
+    closeFile();
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+void EventCapture::attach(EventMsg& eventMsg) {
+    eventMsg.setCaptureTap([this](uint8_t direction, EventSourceId sourceId, const uint8_t* data, size_t length) {
+        this->record(direction, sourceId, data, length);
+    });
+}
+
+void EventCapture::detach(EventMsg& eventMsg) {
+    eventMsg.setCaptureTap(nullptr);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (file != nullptr) fflush(file);
+    xSemaphoreGive(lock);
+}
+
+bool EventCapture::openFile(const char* path) {
+    FILE* f = fopen(path, "ab");
+    if (f == nullptr) return false;
+
+    if (ftell(f) == 0) {
+        uint8_t header[CAPTURE_FILE_HEADER];
+        putFileHeader(header);
+        if (fwrite(header, 1, sizeof(header), f) != sizeof(header)) {
+            fclose(f);
+            return false;
+        }
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    FILE* old = file;
+    file = f;
+    xSemaphoreGive(lock);
+    if (old != nullptr) fclose(old);
+    return true;
+}
+
+void EventCapture::closeFile() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    FILE* old = file;
+    file = nullptr;
+    xSemaphoreGive(lock);
+    if (old != nullptr) fclose(old);
+}
+
+void EventCapture::record(uint8_t direction, EventSourceId sourceId, const uint8_t* data, size_t length) {
+    if (length == 0 || lock == nullptr) return;
+    uint32_t ts = micros();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    while (length > 0) {
+        uint16_t chunk = (uint16_t)(length < CAPTURE_MAX_RECORD ? length : CAPTURE_MAX_RECORD);
+        uint8_t header[CAPTURE_RECORD_HEADER];
+        putHeader(header, ts, sourceId, direction, chunk);
+        size_t total = sizeof(header) + chunk;
+
+        if (!ring.empty()) {
+            if (total > ring.size()) {
+                stats.dropped++;
+            } else {
+                while (ring.size() - ringLen < total) {
+                    ringEvictOldest();
+                }
+                ringWrite(header, sizeof(header));
+                ringWrite(data, chunk);
+            }
+        }
+
+        if (file != nullptr) {
+            if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+                fwrite(data, 1, chunk, file) != chunk) {
+                stats.dropped++;
+            }
+        }
+
+        stats.records++;
+        stats.bytes += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    xSemaphoreGive(lock);
+}
+
+size_t EventCapture::snapshot(PSRAMVector<uint8_t>& out) const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    out.resize(CAPTURE_FILE_HEADER + ringLen);
+    putFileHeader(out.data());
+    ringRead(0, out.data() + CAPTURE_FILE_HEADER, ringLen);
+    xSemaphoreGive(lock);
+    return out.size();
+}
+
+void EventCapture::clear() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    ringHead = 0;
+    ringLen = 0;
+    xSemaphoreGive(lock);
+}
+
+void EventCapture::ringWrite(const uint8_t* data, size_t length) {
+    size_t pos = (ringHead + ringLen) % ring.size();
+    size_t first = ring.size() - pos;
+    if (first > length) first = length;
+    memcpy(ring.data() + pos, data, first);
+    memcpy(ring.data(), data + first, length - first);
+    ringLen += length;
+}
+
+void EventCapture::ringRead(size_t offset, uint8_t* out, size_t length) const {
+    if (length == 0) return;
+    size_t pos = (ringHead + offset) % ring.size();
+    size_t first = ring.size() - pos;
+    if (first > length) first = length;
+    memcpy(out, ring.data() + pos, first);
+    memcpy(out + first, ring.data(), length - first);
+}
+
+void EventCapture::ringEvictOldest() {
+    uint8_t header[CAPTURE_RECORD_HEADER];
+    ringRead(0, header, sizeof(header));
+    size_t total = sizeof(header) + (header[7] | (header[8] << 8));
+    ringHead = (ringHead + total) % ring.size();
+    ringLen -= total;
+    stats.overwritten++;
+}
+
+bool EventReplay::load(const uint8_t* log, size_t length) {
+    close();
+    if (length < CAPTURE_FILE_HEADER || !checkFileHeader(log)) return false;
+    mem = log;
+    memLen = length;
+    rewind();
+    return true;
+}
+
+bool EventReplay::open(const char* path) {
+    close();
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) return false;
+
+    uint8_t header[CAPTURE_FILE_HEADER];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || !checkFileHeader(header)) {
+        fclose(f);
+        return false;
+    }
+    file = f;
+    rewind();
+    return true;
+}
+
+void EventReplay::close() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+    mem = nullptr;
+    memLen = 0;
+    finished = true;
+}
+
+void EventReplay::rewind() {
+    memPos = CAPTURE_FILE_HEADER;
+    if (file != nullptr) {
+        fseek(file, CAPTURE_FILE_HEADER, SEEK_SET);
+    }
+    havePending = false;
+    started = false;
+    finished = (mem == nullptr && file == nullptr);
+    haveTs = false;
+    logElapsedUs = 0;
+    wallElapsedUs = 0;
+    stats = Stats();
+}
+
+bool EventReplay::readRecord() {
+    uint8_t header[CAPTURE_RECORD_HEADER];
+    if (mem != nullptr) {
+        if (memLen - memPos < sizeof(header)) return false;
+        memcpy(header, mem + memPos, sizeof(header));
+    } else if (file == nullptr || fread(header, 1, sizeof(header), file) != sizeof(header)) {
+        return false;
+    }
+
+    uint32_t ts = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+    size_t length = header[7] | (header[8] << 8);
+    pendingSource = (EventSourceId)(header[4] | (header[5] << 8));
+    pendingDir = header[6];
+    pendingData.resize(length);
+
+    if (mem != nullptr) {
+        // A truncated last record ends the replay
+        if (memLen - memPos - sizeof(header) < length) return false;
+        memcpy(pendingData.data(), mem + memPos + sizeof(header), length);
+        memPos += sizeof(header) + length;
+    } else if (fread(pendingData.data(), 1, length, file) != length) {
+        return false;
+    }
+
+    logElapsedUs += haveTs ? (uint32_t)(ts - lastTs) : 0;
+    lastTs = ts;
+    haveTs = true;
+    havePending = true;
+    return true;
+}
+
+void EventReplay::feed() {
+    EventSourceId sourceId = sourceOverride != 0 ? sourceOverride : pendingSource;
+    if (pendingDir == EVENT_CAPTURE_RX) {
+        if (!eventMsg.process(sourceId, pendingData.data(), pendingData.size())) {
+            stats.parseErrors++;
+        }
+        stats.records++;
+        stats.bytes += pendingData.size();
+    } else {
+        if (txCallback) txCallback(sourceId, pendingData.data(), pendingData.size());
+        stats.skipped++;
+    }
+    havePending = false;
+}
+
+bool EventReplay::update() {
+    if (finished) return false;
+
+    uint32_t now = micros();
+    if (!started) {
+        started = true;
+        lastWallUs = now;
+    }
+    wallElapsedUs += (uint32_t)(now - lastWallUs);
+    lastWallUs = now;
+
+    while (true) {
+        if (!havePending && !readRecord()) {
+            finished = true;
+            return false;
+        }
+        if (paced && (double)logElapsedUs > (double)wallElapsedUs * speed) {
+            return true;
+        }
+        feed();
+    }
+}
+
+void EventReplay::run() {
+    while (update()) {
+        delay(1);
+    }
+}
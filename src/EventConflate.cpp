@@ -0,0 +1,225 @@
+#include "EventConflate.h"
+#include <string.h>
+
+Conflator::Table::Table(size_t slots, size_t reserve) : slab(slots > 0 ? slots : 1) {
+    for (size_t i = 0; i < slab.capacity(); i++) {
+        slab[(uint16_t)i].payload.reserve(reserve + 1);
+    }
+}
+
+uint16_t Conflator::Table::find(uint16_t key, const char* name) const {
+    for (uint16_t index = head; index != NONE; index = slab[index].next) {
+        const Slot& slot = slab[index];
+        if (slot.key == key && strcmp(slot.name, name) == 0) return index;
+    }
+    return NONE;
+}
+
+uint16_t Conflator::Table::store(uint16_t key, const char* name, const uint8_t* data, size_t length,
+                                 const EventHeader& header, bool& replaced) {
+    uint16_t index = find(key, name);
+    replaced = (index != NONE);
+    if (!replaced) {
+        index = slab.alloc();
+        if (index == EventSlab<Slot>::NONE) return NONE;
+        Slot& slot = slab[index];
+        slot.key = key;
+        strncpy(slot.name, name, MAX_EVENT_NAME_SIZE);
+        slot.name[MAX_EVENT_NAME_SIZE] = '\0';
+        slot.next = NONE;
+        if (tail == NONE) {
+            head = index;
+        } else {
+            slab[tail].next = index;
+        }
+        tail = index;
+    }
+
+    // Overwriting reuses the slot's buffer, so no allocation either way
+    Slot& slot = slab[index];
+    slot.header = header;
+    slot.payload.assign(data, data + length);
+    slot.payload.push_back('\0');
+    slot.length = length;
+    return index;
+}
+
+uint16_t Conflator::Table::pop() {
+    uint16_t index = head;
+    if (index == NONE) return NONE;
+    head = slab[index].next;
+    if (head == NONE) tail = NONE;
+    return index;
+}
+
+void Conflator::Table::pushFront(uint16_t index) {
+    slab[index].next = head;
+    head = index;
+    if (tail == NONE) tail = index;
+}
+
+Conflator::Conflator(EventMsg& eventMsg, const Config& config)
+    : eventMsg(eventMsg), config(config),
+      received(config.slots, config.payloadReserve), sends(config.slots, config.payloadReserve) {
+    lock = xSemaphoreCreateMutex();
+}
+
+Conflator::~Conflator() {
+    end();
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool Conflator::begin(const char* name) {
+    if (!filterName.empty() || lock == nullptr) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+            return !this->hold(eventName, data, length, header);
+        });
+    if (!registered) return false;
+    filterName = name;
+    return true;
+}
+
+void Conflator::end() {
+    if (!filterName.empty()) {
+        eventMsg.unregisterReceiveFilter(filterName.c_str());
+        filterName.clear();
+    }
+}
+
+void Conflator::setConflated(const char* pattern, bool enabled) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (enabled) {
+        patterns.insert(pattern, 0);
+    } else {
+        patterns.remove(pattern, 0);
+    }
+    xSemaphoreGive(lock);
+}
+
+bool Conflator::hold(const char* eventName, const uint8_t* data, size_t length, const EventHeader& header) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool conflated = false;
+    patterns.match(eventName, [&conflated](uint16_t) { conflated = true; });
+    if (!conflated) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    bool replaced = false;
+    uint16_t index = received.store(header.senderId, eventName, data, length, header, replaced);
+    if (index == NONE) {
+        stats.overflow++;
+        xSemaphoreGive(lock);
+        return false;
+    }
+    stats.received++;
+    if (replaced) stats.rxReplaced++;
+    xSemaphoreGive(lock);
+    return true;
+}
+
+size_t Conflator::dispatch(size_t maxEvents) {
+    size_t count = 0;
+    while (maxEvents == 0 || count < maxEvents) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        uint16_t index = received.pop();
+        xSemaphoreGive(lock);
+        if (index == NONE) break;
+
+        // Off the pending list, so a newer frame takes a fresh slot
+        // instead of overwriting this one mid-dispatch
+        Slot& slot = received.slab[index];
+        EventHeader header = slot.header;
+        eventMsg.deliver(slot.name, slot.payload.data(), slot.length, header);
+        count++;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        received.slab.free(index);
+        stats.dispatched++;
+        xSemaphoreGive(lock);
+    }
+    return count;
+}
+
+bool Conflator::sendConflated(const char* name, const uint8_t* data, size_t length, const EventHeader& header) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool replaced = false;
+    uint16_t index = sends.store(sendKey(header), name, data, length, header, replaced);
+    if (index != NONE) {
+        stats.queued++;
+        if (replaced) stats.txReplaced++;
+        xSemaphoreGive(lock);
+        return true;
+    }
+    stats.overflow++;
+    xSemaphoreGive(lock);
+
+    return eventMsg.send(name, data, length, header) > 0;
+}
+
+size_t Conflator::flush() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t remaining = sends.slab.size();
+    xSemaphoreGive(lock);
+
+    // Only what was pending on entry, so a busy sender cannot keep us here
+    size_t count = 0;
+    for (; remaining > 0; remaining--) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        uint16_t index = sends.pop();
+        xSemaphoreGive(lock);
+        if (index == NONE) break;
+
+        Slot& slot = sends.slab[index];
+        bool ok = eventMsg.send(slot.name, slot.payload.data(), slot.length, slot.header) > 0;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (ok) {
+            sends.slab.free(index);
+            stats.sent++;
+            count++;
+        } else if (sends.find(slot.key, slot.name) != NONE) {
+            // Superseded while we were sending
+            sends.slab.free(index);
+        } else {
+            sends.pushFront(index);
+        }
+        xSemaphoreGive(lock);
+        if (!ok) break;  // The link is likely paused; retry next flush
+    }
+    return count;
+}
+
+void Conflator::update() {
+    dispatch();
+    uint32_t now = millis();
+    if (config.sendInterval == 0 || now - lastFlush >= config.sendInterval) {
+        lastFlush = now;
+        flush();
+    }
+}
+
+size_t Conflator::pendingReceived() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t result = received.slab.size();
+    xSemaphoreGive(lock);
+    return result;
+}
+
+size_t Conflator::pendingSends() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t result = sends.slab.size();
+    xSemaphoreGive(lock);
+    return result;
+}
+
+Conflator::Stats Conflator::getStats() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Stats result = stats;
+    xSemaphoreGive(lock);
+    return result;
+}
@@ -0,0 +1,46 @@
+#include "EventCrc.h"
+
+// Tables are built at compile time and land in flash/rodata
+const EventCrc::Tables EventCrc::tables = EventCrc::makeTables();
+
+uint16_t EventCrc::crc16(uint16_t crc, const uint8_t* data, size_t len) {
+#if EVENT_CRC_USE_ROM
+    // ROM routine inverts on entry and exit, undo both to stay on the raw register
+    return (uint16_t)~esp_rom_crc16_be((uint16_t)~crc, data, len);
+#else
+    for (size_t i = 0; i < len; i++) {
+        crc = crc16Update(crc, data[i]);
+    }
+    return crc;
+#endif
+}
+
+uint32_t EventCrc::crc32(uint32_t crc, const uint8_t* data, size_t len) {
+#if EVENT_CRC_USE_ROM
+    return ~esp_rom_crc32_le(~crc, data, len);
+#else
+    const uint32_t (*t)[256] = tables.crc32;
+
+    // Slice-by-8: fold eight input bytes per iteration
+    while (len >= 8) {
+        uint32_t one = crc ^ ((uint32_t)data[0] |
+                              ((uint32_t)data[1] << 8) |
+                              ((uint32_t)data[2] << 16) |
+                              ((uint32_t)data[3] << 24));
+        uint32_t two = (uint32_t)data[4] |
+                       ((uint32_t)data[5] << 8) |
+                       ((uint32_t)data[6] << 16) |
+                       ((uint32_t)data[7] << 24);
+        crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^
+              t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+              t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^
+              t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+        data += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = crc32Update(crc, *data++);
+    }
+    return crc;
+#endif
+}
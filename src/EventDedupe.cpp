@@ -0,0 +1,97 @@
+#include "EventDedupe.h"
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+DuplicateFilter::DuplicateFilter(EventMsg& eventMsg, size_t capacity)
+    : eventMsg(eventMsg), table(roundUpPow2(capacity > 0 ? capacity : 1)) {
+    mask = table.size() - 1;
+}
+
+DuplicateFilter::~DuplicateFilter() {
+    end();
+}
+
+bool DuplicateFilter::begin(const char* name) {
+    if (!filterName.empty()) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId, const char*, const uint8_t*, size_t, EventHeader& header) {
+            if (header.flags & (EVENT_FLAG_RELIABLE | EVENT_FLAG_RESPONSE)) return true;
+            return !this->check(header.senderId, header.msgId);
+        });
+    if (!registered) return false;
+    filterName = name;
+    return true;
+}
+
+void DuplicateFilter::end() {
+    if (!filterName.empty()) {
+        eventMsg.unregisterReceiveFilter(filterName.c_str());
+        filterName.clear();
+    }
+}
+
+void DuplicateFilter::clear() {
+    for (auto& entry : table) {
+        entry.used = false;
+    }
+}
+
+bool DuplicateFilter::check(uint8_t senderId, uint16_t msgId) {
+    // Linear probe from the sender's home slot
+    size_t home = (senderId * 0x9Du) & mask;
+    Entry* entry = nullptr;
+    for (size_t i = 0; i <= mask; i++) {
+        Entry& candidate = table[(home + i) & mask];
+        if (!candidate.used || candidate.senderId == senderId) {
+            entry = &candidate;
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        entry = &table[home];
+        entry->used = false;
+        stats.evictions++;
+    }
+
+    if (!entry->used) {
+        entry->used = true;
+        entry->senderId = senderId;
+        entry->highest = msgId;
+        entry->seen = 1;
+        stats.misses++;
+        return false;
+    }
+
+    int16_t delta = (int16_t)(msgId - entry->highest);
+    if (delta > 0) {
+        // Newer than anything seen: slide the window forward
+        entry->seen = (delta >= DEDUPE_WINDOW) ? 1 : ((entry->seen << delta) | 1);
+        entry->highest = msgId;
+        stats.misses++;
+        return false;
+    }
+
+    uint16_t age = (uint16_t)(-delta);
+    if (age >= DEDUPE_WINDOW) {
+        // Too old to judge: most likely the sender restarted its counter
+        entry->highest = msgId;
+        entry->seen = 1;
+        stats.resets++;
+        stats.misses++;
+        return false;
+    }
+
+    uint64_t bit = 1ULL << age;
+    if (entry->seen & bit) {
+        stats.hits++;
+        return true;
+    }
+    entry->seen |= bit;
+    stats.misses++;
+    return false;
+}
@@ -0,0 +1,140 @@
+#include "EventDeferred.h"
+#include <string.h>
+
+DeferredDispatch::DeferredDispatch(EventMsg& eventMsg, const Config& config)
+    : eventMsg(eventMsg), config(config), slab(config.slots > 0 ? config.slots : 1) {
+    for (size_t i = 0; i < slab.capacity(); i++) {
+        slab[(uint16_t)i].payload.reserve((size_t)this->config.payloadReserve + 1);
+    }
+    lock = xSemaphoreCreateMutex();
+}
+
+DeferredDispatch::~DeferredDispatch() {
+    end();
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool DeferredDispatch::begin(const char* name) {
+    if (!filterName.empty() || lock == nullptr) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+            // Queued or dropped, the frame stops here either way
+            this->enqueue(sourceId, eventName, data, length, header);
+            return false;
+        });
+    if (!registered) return false;
+    filterName = name;
+    return true;
+}
+
+void DeferredDispatch::end() {
+    if (!filterName.empty()) {
+        eventMsg.unregisterReceiveFilter(filterName.c_str());
+        filterName.clear();
+    }
+}
+
+bool DeferredDispatch::enqueue(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length,
+                               const EventHeader& header) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint16_t index = slab.alloc();
+    if (index == EventSlab<Slot>::NONE) {
+        stats.dropped++;
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    Slot& slot = slab[index];
+    slot.sourceId = sourceId;
+    slot.header = header;
+    strncpy(slot.name, eventName, MAX_EVENT_NAME_SIZE);
+    slot.name[MAX_EVENT_NAME_SIZE] = '\0';
+    slot.payload.assign(data, data + length);
+    slot.payload.push_back('\0');
+    slot.length = length;
+    slot.next = NONE;
+
+    Lane& lane = lanes[config.order == ORDER_PER_SOURCE ? sourceId : 0];
+    if (lane.tail == NONE) {
+        lane.head = index;
+    } else {
+        slab[lane.tail].next = index;
+    }
+    lane.tail = index;
+
+    stats.queued++;
+    if (slab.size() > stats.highWater) {
+        stats.highWater = (uint16_t)slab.size();
+    }
+    TaskHandle_t task = notifyTask;
+    xSemaphoreGive(lock);
+
+    if (task != nullptr) {
+        xTaskNotifyGive(task);
+    }
+    return true;
+}
+
+uint16_t DeferredDispatch::takeLocked() {
+    if (lanes.empty()) return NONE;
+
+    // Start with the lane after the one served last
+    auto it = lanes.upper_bound(lastLane);
+    for (size_t n = 0; n < lanes.size(); n++, ++it) {
+        if (it == lanes.end()) it = lanes.begin();
+        Lane& lane = it->second;
+        if (lane.head == NONE) continue;
+
+        uint16_t index = lane.head;
+        lane.head = slab[index].next;
+        if (lane.head == NONE) lane.tail = NONE;
+        lastLane = it->first;
+        return index;
+    }
+    return NONE;
+}
+
+size_t DeferredDispatch::dispatch(size_t maxEvents) {
+    size_t count = 0;
+    while (maxEvents == 0 || count < maxEvents) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        uint16_t index = takeLocked();
+        xSemaphoreGive(lock);
+        if (index == NONE) break;
+
+        // The slot stays allocated, so the parser cannot reuse it meanwhile
+        Slot& slot = slab[index];
+        EventHeader header = slot.header;
+        eventMsg.deliver(slot.name, slot.payload.data(), slot.length, header);
+        count++;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        slab.free(index);
+        stats.dispatched++;
+        xSemaphoreGive(lock);
+    }
+    return count;
+}
+
+void DeferredDispatch::setNotifyTask(TaskHandle_t task) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    notifyTask = task;
+    xSemaphoreGive(lock);
+}
+
+size_t DeferredDispatch::pending() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t result = slab.size();
+    xSemaphoreGive(lock);
+    return result;
+}
+
+DeferredDispatch::Stats DeferredDispatch::getStats() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Stats result = stats;
+    xSemaphoreGive(lock);
+    return result;
+}
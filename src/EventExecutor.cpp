@@ -0,0 +1,224 @@
+#include "EventExecutor.h"
+#include <string.h>
+
+EventExecutor::EventExecutor(const Config& config)
+    : config(config), slab(config.slots > 0 ? config.slots : 1),
+      workers(config.workers > 0 ? config.workers : 1), running(false), exited(0) {
+    for (size_t i = 0; i < slab.capacity(); i++) {
+        slab[(uint16_t)i].payload.reserve((size_t)this->config.payloadReserve + 1);
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].owner = this;
+        workers[i].index = (uint8_t)i;
+        workers[i].core = this->config.pinned ? (BaseType_t)(i % portNUM_PROCESSORS) : tskNO_AFFINITY;
+    }
+    lock = xSemaphoreCreateMutex();
+}
+
+EventExecutor::~EventExecutor() {
+    stop();
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool EventExecutor::start() {
+    if (lock == nullptr) return false;
+    if (running.load()) return true;
+
+    running = true;
+    exited = 0;
+    bool ok = true;
+    for (auto& worker : workers) {
+        if (xTaskCreatePinnedToCore(workerMain, "EventExec", config.stackSize, &worker,
+                                    config.priority, nullptr, worker.core) != pdPASS) {
+            exited++;
+            ok = false;
+        }
+    }
+    if (!ok) stop();
+    return ok;
+}
+
+void EventExecutor::stop() {
+    if (!running.exchange(false)) return;
+
+    // Tasks clear their handle under the lock before exiting, so every
+    // handle seen here is still live
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto& worker : workers) {
+        if (worker.task != nullptr) xTaskNotifyGive(worker.task);
+    }
+    xSemaphoreGive(lock);
+    while (exited.load() < workers.size()) {
+        delay(1);
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto& worker : workers) {
+        for (Fifo* fifo : {&worker.own, &worker.shared}) {
+            for (uint16_t index = popLocked(*fifo); index != NONE; index = popLocked(*fifo)) {
+                slab[index].handler.reset();
+                slab.free(index);
+            }
+        }
+        worker.idle = false;
+    }
+    xSemaphoreGive(lock);
+}
+
+bool EventExecutor::post(const std::shared_ptr<const Handler>& handler, const ExecPolicy& policy, uint32_t eventKey,
+                         const char* data, size_t length, const EventHeader& header) {
+    if (!running.load() || !handler) return false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint16_t index = slab.alloc();
+    if (index == EventSlab<Job>::NONE) {
+        stats.dropped++;
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    Job& job = slab[index];
+    job.handler = handler;
+    job.header = header;
+    job.payload.assign((const uint8_t*)data, (const uint8_t*)data + length);
+    job.payload.push_back('\0');
+    job.length = length;
+
+    uint32_t key = policy.order == ExecPolicy::ORDER_SENDER ? header.senderId : eventKey;
+    Worker& target = workers[pickWorker(policy, key)];
+    bool stealable = policy.mode == ExecPolicy::POOLED && policy.order == ExecPolicy::ORDER_NONE;
+    pushLocked(stealable ? target.shared : target.own, index);
+    stats.posted++;
+
+    // Wake the target; if it is busy, wake an idle worker to steal
+    bool targetBusy = !target.idle;
+    if (target.task != nullptr) {
+        target.idle = false;
+        xTaskNotifyGive(target.task);
+    }
+    if (stealable && targetBusy) {
+        for (auto& worker : workers) {
+            if (worker.idle && worker.task != nullptr) {
+                worker.idle = false;
+                xTaskNotifyGive(worker.task);
+                break;
+            }
+        }
+    }
+    xSemaphoreGive(lock);
+    return true;
+}
+
+uint8_t EventExecutor::pickWorker(const ExecPolicy& policy, uint32_t key) {
+    size_t first = 0;
+    size_t stride = 1;
+    size_t eligible = workers.size();
+    if (policy.mode == ExecPolicy::PINNED && config.pinned && policy.core < workers.size() &&
+        policy.core < portNUM_PROCESSORS) {
+        first = policy.core;
+        stride = portNUM_PROCESSORS;
+        eligible = (workers.size() - first + stride - 1) / stride;
+    }
+
+    uint32_t slot;
+    if (policy.order == ExecPolicy::ORDER_NONE) {
+        slot = nextWorker++;
+    } else {
+        // Spread small keys (sender IDs) across workers
+        slot = key * 0x9E3779B1u;
+        slot ^= slot >> 16;
+    }
+    return (uint8_t)(first + (slot % eligible) * stride);
+}
+
+void EventExecutor::pushLocked(Fifo& fifo, uint16_t index) {
+    slab[index].next = NONE;
+    if (fifo.tail == NONE) {
+        fifo.head = index;
+    } else {
+        slab[fifo.tail].next = index;
+    }
+    fifo.tail = index;
+}
+
+uint16_t EventExecutor::popLocked(Fifo& fifo) {
+    uint16_t index = fifo.head;
+    if (index == NONE) return NONE;
+    fifo.head = slab[index].next;
+    if (fifo.head == NONE) fifo.tail = NONE;
+    return index;
+}
+
+uint16_t EventExecutor::takeLocked(Worker& worker) {
+    uint16_t index = popLocked(worker.own);
+    if (index == NONE) index = popLocked(worker.shared);
+    if (index != NONE) return index;
+
+    for (size_t i = 1; i < workers.size(); i++) {
+        Worker& victim = workers[(worker.index + i) % workers.size()];
+        index = popLocked(victim.shared);
+        if (index != NONE) {
+            stats.stolen++;
+            return index;
+        }
+    }
+    return NONE;
+}
+
+void EventExecutor::workerMain(void* arg) {
+    Worker* worker = static_cast<Worker*>(arg);
+    worker->owner->runWorker(*worker);
+    // Nothing of the executor may be touched after this: stop() may free it
+    worker->owner->exited.fetch_add(1);
+    vTaskDelete(nullptr);
+}
+
+void EventExecutor::runWorker(Worker& worker) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    worker.task = xTaskGetCurrentTaskHandle();
+    xSemaphoreGive(lock);
+
+    while (running.load()) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        uint16_t index = takeLocked(worker);
+        worker.idle = (index == NONE);
+        xSemaphoreGive(lock);
+
+        if (index == NONE) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        // The slot stays allocated, so post() cannot reuse it meanwhile
+        Job& job = slab[index];
+        EventHeader header = job.header;
+        (*job.handler)((const char*)job.payload.data(), job.length, header);
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        job.handler.reset();
+        slab.free(index);
+        stats.executed++;
+        xSemaphoreGive(lock);
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    worker.task = nullptr;
+    worker.idle = false;
+    xSemaphoreGive(lock);
+}
+
+size_t EventExecutor::pending() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t result = slab.size();
+    xSemaphoreGive(lock);
+    return result;
+}
+
+EventExecutor::Stats EventExecutor::getStats() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Stats result = stats;
+    xSemaphoreGive(lock);
+    return result;
+}
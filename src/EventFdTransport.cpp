@@ -0,0 +1,422 @@
+#include "EventFdTransport.h"
+
+#if EVENT_FD_TRANSPORT_AVAILABLE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+// epoll data carries the source ID, never a pointer, so a connection
+// removed by another thread can't be touched through a stale event
+#define FD_WAKE_TAG   0xFFFFFFFFu
+#define FD_LISTEN_TAG 0x80000000u  // | listening fd
+
+FdTransport::FdTransport(EventMsg& eventMsg, size_t maxPendingWrite)
+    : eventMsg(eventMsg), maxPendingWrite(maxPendingWrite) {
+}
+
+FdTransport::~FdTransport() {
+    end();
+}
+
+bool FdTransport::begin() {
+    if (epollFd >= 0) return true;
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        end();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = FD_WAKE_TAG;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    return true;
+}
+
+void FdTransport::end() {
+    stop();
+
+    std::vector<EventSourceId> ids;
+    std::vector<int> listenFds;
+    {
+        std::lock_guard<std::mutex> guard(connLock);
+        for (auto& entry : conns) ids.push_back(entry.first);
+        for (auto& entry : listeners) listenFds.push_back(entry.first);
+    }
+    for (EventSourceId id : ids) removeFd(id);
+    for (int fd : listenFds) removeListener(fd);
+
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+    wakeFd = epollFd = -1;
+}
+
+bool FdTransport::start() {
+    if (running || !begin()) return false;
+    running = true;
+    reactor = std::thread([this]() {
+        while (running) {
+            poll(-1);
+        }
+    });
+    return true;
+}
+
+void FdTransport::stop() {
+    if (!running) return;
+    running = false;
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+    if (reactor.joinable()) reactor.join();
+    // Anything posted after the reactor's last pass
+    runPosted();
+}
+
+EventSourceId FdTransport::addFd(int fd, bool ownsFd, FdCloseCallback onClose) {
+    if (fd < 0 || !begin()) return 0;
+
+    int fl = fcntl(fd, F_GETFL, 0);
+    if (fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) return 0;
+
+    // createDirectSource() changes the tables the reactor parses with
+    EventSourceId sourceId = 0;
+    onReactor([&] { sourceId = addNow(fd, ownsFd, onClose); });
+    return sourceId;
+}
+
+EventSourceId FdTransport::addNow(int fd, bool ownsFd, FdCloseCallback onClose) {
+    // Reads bypass the source queue, so no queue is allocated
+    EventSourceId sourceId = eventMsg.createDirectSource();
+    if (sourceId == 0) return 0;  // Source IDs exhausted
+
+    auto conn = std::make_shared<Conn>();
+    struct stat st;
+    conn->fd = fd;
+    conn->sourceId = sourceId;
+    conn->ownsFd = ownsFd;
+    conn->isSocket = (fstat(fd, &st) == 0 && S_ISSOCK(st.st_mode));
+    conn->onClose = onClose;
+
+    {
+        std::lock_guard<std::mutex> guard(connLock);
+        conns[sourceId] = conn;
+    }
+
+    // Before the fd is armed: a frame that arrives at once must be able to
+    // route its reply back here rather than flood every link
+    eventMsg.setSourceTransport(sourceId, [this, conn](uint8_t* data, size_t len) {
+        return this->write(*conn, data, len);
+    });
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = sourceId;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        {
+            std::lock_guard<std::mutex> guard(connLock);
+            conns.erase(sourceId);
+        }
+        eventMsg.removeSource(sourceId);
+        return 0;
+    }
+    return sourceId;
+}
+
+bool FdTransport::removeFd(EventSourceId sourceId) {
+    // Posted even if the fd is gone already: the reactor may still be in
+    // its close callbacks, and the caller may be about to free what they use
+    bool removed = false;
+    onReactor([&] { removed = removeNow(sourceId); });
+    return removed;
+}
+
+void FdTransport::onReactor(const std::function<void()>& work) {
+    if (!running || std::this_thread::get_id() == reactor.get_id()) {
+        work();
+        return;
+    }
+
+    std::unique_lock<std::mutex> guard(postLock);
+    posted.push_back(work);
+    uint64_t ticket = ++postedCount;
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+    postDone.wait(guard, [&] { return runCount >= ticket; });
+}
+
+void FdTransport::runPosted() {
+    std::vector<std::function<void()>> batch;
+    uint64_t count;
+    {
+        std::lock_guard<std::mutex> guard(postLock);
+        if (runCount == postedCount) return;
+        batch.swap(posted);
+        count = postedCount;
+    }
+    for (auto& work : batch) work();
+    {
+        std::lock_guard<std::mutex> guard(postLock);
+        runCount = count;
+    }
+    postDone.notify_all();
+}
+
+bool FdTransport::removeNow(EventSourceId sourceId) {
+    ConnPtr conn;
+    {
+        std::lock_guard<std::mutex> guard(connLock);
+        auto it = conns.find(sourceId);
+        if (it == conns.end()) return false;
+        conn = it->second;
+        conns.erase(it);
+    }
+
+    eventMsg.removeSource(sourceId);
+
+    std::lock_guard<std::mutex> guard(conn->lock);
+    if (conn->open) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+        conn->open = false;
+        if (conn->ownsFd) ::close(conn->fd);
+    }
+    conn->pending.clear();
+    return true;
+}
+
+bool FdTransport::shutdownFd(EventSourceId sourceId) {
+    ConnPtr conn = find(sourceId);
+    if (!conn) return false;
+    std::lock_guard<std::mutex> guard(conn->lock);
+    return conn->open && ::shutdown(conn->fd, SHUT_RDWR) == 0;
+}
+
+bool FdTransport::addListener(int listenFd, FdAcceptCallback cb) {
+    if (listenFd < 0 || !cb || !begin()) return false;
+
+    int fl = fcntl(listenFd, F_GETFL, 0);
+    if (fl < 0 || fcntl(listenFd, F_SETFL, fl | O_NONBLOCK) < 0) return false;
+
+    {
+        std::lock_guard<std::mutex> guard(connLock);
+        listeners[listenFd] = cb;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = FD_LISTEN_TAG | (uint32_t)listenFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) < 0) {
+        std::lock_guard<std::mutex> guard(connLock);
+        listeners.erase(listenFd);
+        return false;
+    }
+    return true;
+}
+
+bool FdTransport::removeListener(int listenFd) {
+    std::lock_guard<std::mutex> guard(connLock);
+    if (listeners.erase(listenFd) == 0) return false;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+    return true;
+}
+
+void FdTransport::handleAccept(int listenFd) {
+    FdAcceptCallback cb;
+    {
+        std::lock_guard<std::mutex> guard(connLock);
+        auto it = listeners.find(listenFd);
+        if (it == listeners.end()) return;
+        cb = it->second;
+    }
+
+    // Bounded like reads, so an accept storm can't starve open connections
+    for (int i = 0; i < FD_READS_PER_WAKE * 4; i++) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        cb(fd);
+    }
+}
+
+size_t FdTransport::getFdCount() const {
+    std::lock_guard<std::mutex> guard(connLock);
+    return conns.size();
+}
+
+size_t FdTransport::pendingWrite(EventSourceId sourceId) const {
+    ConnPtr conn = find(sourceId);
+    if (!conn) return 0;
+    std::lock_guard<std::mutex> guard(conn->lock);
+    return conn->pending.size() - conn->pendingOff;
+}
+
+FdTransport::ConnPtr FdTransport::find(EventSourceId sourceId) const {
+    std::lock_guard<std::mutex> guard(connLock);
+    auto it = conns.find(sourceId);
+    return it != conns.end() ? it->second : nullptr;
+}
+
+int FdTransport::poll(int timeoutMs) {
+    if (epollFd < 0) return -1;
+
+    epoll_event events[FD_MAX_EVENTS];
+    int n = epoll_wait(epollFd, events, FD_MAX_EVENTS, timeoutMs);
+    if (n < 0) return (errno == EINTR) ? 0 : -1;
+
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.u32 == FD_WAKE_TAG) {
+            uint64_t count;
+            ssize_t ignored = ::read(wakeFd, &count, sizeof(count));
+            (void)ignored;
+            runPosted();
+            continue;
+        }
+        if (events[i].data.u32 & FD_LISTEN_TAG) {
+            handleAccept((int)(events[i].data.u32 & ~FD_LISTEN_TAG));
+            continue;
+        }
+
+        ConnPtr conn = find((EventSourceId)events[i].data.u32);
+        if (!conn) continue;
+
+        if (events[i].events & EPOLLOUT) {
+            handleWrite(*conn);
+        }
+        // HUP and ERR are reported through read() returning 0 or an error
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            handleRead(*conn);
+        }
+    }
+    return n;
+}
+
+void FdTransport::handleRead(Conn& conn) {
+    for (int i = 0; i < FD_READS_PER_WAKE && conn.open; i++) {
+        ssize_t n = ::read(conn.fd, readBuf, sizeof(readBuf));
+        if (n > 0) {
+            stats.bytesIn += n;
+            stats.reads++;
+            eventMsg.process(conn.sourceId, readBuf, n);
+            if ((size_t)n < sizeof(readBuf)) return;  // Drained
+        } else if (n < 0 && errno == EINTR) {
+            i--;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            // EOF, or EIO from a pty whose other side went away
+            closeConn(conn);
+        }
+    }
+}
+
+void FdTransport::closeConn(Conn& conn) {
+    {
+        std::lock_guard<std::mutex> guard(conn.lock);
+        if (!conn.open) return;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+        conn.open = false;
+        if (conn.ownsFd) ::close(conn.fd);
+        conn.pending.clear();
+        conn.pendingOff = 0;
+    }
+    stats.closed++;
+
+    // The source stays registered, failing writes, until removeFd()
+    if (conn.onClose) {
+        conn.onClose(conn.sourceId, conn.fd);
+    }
+    if (closeCallback) {
+        closeCallback(conn.sourceId, conn.fd);
+    }
+}
+
+ssize_t FdTransport::writeSome(Conn& conn, const uint8_t* data, size_t len) {
+    // MSG_NOSIGNAL: a dead peer must not raise SIGPIPE in the host process
+    return conn.isSocket ? ::send(conn.fd, data, len, MSG_NOSIGNAL)
+                         : ::write(conn.fd, data, len);
+}
+
+bool FdTransport::write(Conn& conn, const uint8_t* data, size_t len) {
+    std::lock_guard<std::mutex> guard(conn.lock);
+    if (!conn.open) {
+        stats.writeDrops++;
+        return false;
+    }
+
+    size_t queued = conn.pending.size() - conn.pendingOff;
+    size_t off = 0;
+    if (queued == 0) {
+        while (off < len) {
+            ssize_t n = writeSome(conn, data + off, len - off);
+            if (n > 0) {
+                off += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                // Let the reactor notice the error and close the fd
+                stats.writeDrops++;
+                return false;
+            }
+        }
+        stats.bytesOut += off;
+        if (off == len) return true;
+    } else if (queued + len > maxPendingWrite) {
+        // Refuse whole frames only; a frame already started must finish
+        stats.writeDrops++;
+        return false;
+    }
+
+    // Keep the stream contiguous: the rest goes out on EPOLLOUT
+    if (conn.pendingOff > 0 && conn.pendingOff == conn.pending.size()) {
+        conn.pending.clear();
+        conn.pendingOff = 0;
+    }
+    conn.pending.insert(conn.pending.end(), data + off, data + len);
+    stats.partialWrites++;
+    if (!conn.wantWrite) arm(conn, true);
+    return true;
+}
+
+void FdTransport::handleWrite(Conn& conn) {
+    std::lock_guard<std::mutex> guard(conn.lock);
+    if (!conn.open) return;
+
+    while (conn.pendingOff < conn.pending.size()) {
+        ssize_t n = writeSome(conn, conn.pending.data() + conn.pendingOff,
+                              conn.pending.size() - conn.pendingOff);
+        if (n > 0) {
+            conn.pendingOff += n;
+            stats.bytesOut += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // EAGAIN: wait for the next EPOLLOUT. Errors surface on read.
+            return;
+        }
+    }
+
+    conn.pending.clear();
+    conn.pendingOff = 0;
+    arm(conn, false);
+}
+
+void FdTransport::arm(Conn& conn, bool wantWrite) {
+    epoll_event ev{};
+    uint32_t mask = EPOLLIN;
+    if (wantWrite) mask |= EPOLLOUT;
+    ev.events = mask;
+    ev.data.u32 = conn.sourceId;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.wantWrite = wantWrite;
+}
+
+#endif // EVENT_FD_TRANSPORT_AVAILABLE
@@ -0,0 +1,151 @@
+#include "EventFlow.h"
+#include <string.h>
+
+FlowControl::FlowControl(EventMsg& eventMsg, uint8_t localAddr, const Config& config)
+    : eventMsg(eventMsg), localAddr(localAddr), config(config) {
+    if (this->config.highWater == 0) this->config.highWater = 1;
+    if (this->config.lowWater >= this->config.highWater) this->config.lowWater = this->config.highWater - 1;
+    if (this->config.refresh == 0 || this->config.refresh >= this->config.holdTime) {
+        this->config.refresh = this->config.holdTime / 2;
+    }
+    lock = xSemaphoreCreateMutex();
+}
+
+FlowControl::~FlowControl() {
+    end();
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool FlowControl::begin(const char* name) {
+    if (!filterName.empty() || lock == nullptr) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader&) {
+            return this->onFrame(sourceId, eventName, data, length);
+        });
+    if (!registered) return false;
+    filterName = name;
+
+    eventMsg.getSourceManager().onFlowSignal([this](EventSourceId sourceId, uint8_t signal) {
+        this->onSignal(sourceId, signal);
+    });
+    eventMsg.getSourceManager().setWatermarks(config.highWater, config.lowWater);
+    return true;
+}
+
+void FlowControl::end() {
+    if (filterName.empty()) return;
+
+    eventMsg.getSourceManager().setWatermarks(0, 0);
+    eventMsg.getSourceManager().onFlowSignal(nullptr);
+    eventMsg.unregisterReceiveFilter(filterName.c_str());
+    filterName.clear();
+
+    // Release peers now rather than leaving them to time out
+    xSemaphoreTake(lock, portMAX_DELAY);
+    std::map<EventSourceId, uint32_t> released;
+    released.swap(throttled);
+    xSemaphoreGive(lock);
+    for (auto it = released.begin(); it != released.end(); ++it) {
+        sendControl(it->first, FLOW_XON_EVENT, nullptr, 0);
+    }
+}
+
+void FlowControl::update() {
+    if (filterName.empty()) return;
+
+    uint32_t now = millis();
+    std::vector<EventSourceId> due;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto it = throttled.begin(); it != throttled.end();) {
+        if (!eventMsg.getSourceManager().hasSource(it->first)) {
+            it = throttled.erase(it);
+            continue;
+        }
+        if (now - it->second >= config.refresh) {
+            it->second = now;
+            due.push_back(it->first);
+        }
+        ++it;
+    }
+    xSemaphoreGive(lock);
+
+    for (EventSourceId sourceId : due) {
+        sendXoff(sourceId);
+    }
+}
+
+bool FlowControl::isThrottled(EventSourceId sourceId) const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool result = throttled.find(sourceId) != throttled.end();
+    xSemaphoreGive(lock);
+    return result;
+}
+
+void FlowControl::onSignal(EventSourceId sourceId, uint8_t signal) {
+    uint32_t now = millis();
+    bool notify = false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (signal == FLOW_SIGNAL_XOFF) {
+        // Repeats from a full queue are limited to one per refresh interval
+        auto it = throttled.find(sourceId);
+        if (it == throttled.end() || now - it->second >= config.refresh) {
+            throttled[sourceId] = now;
+            notify = true;
+        }
+    } else if (signal == FLOW_SIGNAL_XON) {
+        notify = throttled.erase(sourceId) != 0;
+    }
+    xSemaphoreGive(lock);
+
+    if (!notify) return;
+    if (signal == FLOW_SIGNAL_XOFF) {
+        sendXoff(sourceId);
+    } else {
+        sendControl(sourceId, FLOW_XON_EVENT, nullptr, 0);
+    }
+}
+
+bool FlowControl::onFrame(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length) {
+    // Pause whichever transport carries our frames back to this peer
+    EventSourceId link = eventMsg.hasSourceTransport(sourceId) ? sourceId : 0;
+
+    if (strcmp(eventName, FLOW_XOFF_EVENT) == 0) {
+        uint32_t hold = length >= 2 ? (uint32_t)((data[0] << 8) | data[1]) : 0;
+        eventMsg.pauseTransport(link, hold != 0 ? hold : config.holdTime);
+        stats.xoffReceived++;
+        return false;
+    }
+    if (strcmp(eventName, FLOW_XON_EVENT) == 0) {
+        eventMsg.resumeTransport(link);
+        stats.xonReceived++;
+        return false;
+    }
+    return true;
+}
+
+void FlowControl::sendXoff(EventSourceId sourceId) {
+    uint8_t payload[2] = {(uint8_t)(config.holdTime >> 8), (uint8_t)(config.holdTime & 0xFF)};
+    sendControl(sourceId, FLOW_XOFF_EVENT, payload, sizeof(payload));
+}
+
+void FlowControl::sendControl(EventSourceId sourceId, const char* name, const uint8_t* data, size_t length) {
+    EventHeader header{localAddr, BROADCAST_ADDR, 0x00, 0x00};
+    PSRAMVector<uint8_t> frame;
+    size_t frameLen = eventMsg.encodeFrame(name, data, length, header, eventMsg.nextMsgId(), frame);
+    if (frameLen == 0) return;
+
+    EventSourceId link = eventMsg.hasSourceTransport(sourceId) ? sourceId : 0;
+    if (!eventMsg.writeFrameTo(link, frame.data(), frameLen, true)) return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (strcmp(name, FLOW_XOFF_EVENT) == 0) {
+        stats.xoffSent++;
+    } else {
+        stats.xonSent++;
+    }
+    xSemaphoreGive(lock);
+}
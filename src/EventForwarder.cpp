@@ -0,0 +1,210 @@
+#include "EventForwarder.h"
+#include <string.h>
+
+// Largest stuffed frame the forwarder will buffer
+#define FORWARD_MAX_FRAME (4 + (MAX_HEADER_SIZE + MAX_EVENT_NAME_SIZE + MAX_EVENT_DATA_SIZE + EVENT_CRC_MAX_SIZE) * 2)
+
+void EventForwarder::addPort(EventSourceId sourceId) {
+    for (EventSourceId port : ports) {
+        if (port == sourceId) return;
+    }
+    ports.push_back(sourceId);
+}
+
+void EventForwarder::removePort(EventSourceId sourceId) {
+    for (auto it = ports.begin(); it != ports.end(); ++it) {
+        if (*it == sourceId) {
+            ports.erase(it);
+            return;
+        }
+    }
+}
+
+void EventForwarder::processAllSources() {
+    eventMsg.getSourceManager().processAll([this](EventSourceId sourceId, uint8_t* data, size_t length) {
+        this->process(sourceId, data, length);
+    });
+}
+
+bool EventForwarder::process(EventSourceId sourceId, const uint8_t* data, size_t len) {
+    PortState& port = portStates[sourceId];
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+    bool ok = true;
+
+    while (p < end) {
+        switch (port.phase) {
+            case Phase::IDLE: {
+                // Skip noise between frames
+                const uint8_t* soh = (const uint8_t*)memchr(p, SOH, end - p);
+                if (soh == nullptr) return ok;
+                p = soh + 1;
+                port.phase = Phase::HEADER;
+                port.escaped = false;
+                port.headerLen = 0;
+                port.rawHeader[0] = SOH;
+                port.rawHeaderLen = 1;
+                break;
+            }
+
+            case Phase::HEADER: {
+                uint8_t byte = *p++;
+                if (port.escaped) {
+                    byte ^= 0x20;
+                    port.escaped = false;
+                } else if (byte == ESC) {
+                    port.rawHeader[port.rawHeaderLen++] = byte;
+                    port.escaped = true;
+                    break;
+                } else if (byte == SOH) {
+                    // Truncated header, start over at this SOH
+                    port.headerLen = 0;
+                    port.rawHeaderLen = 1;
+                    break;
+                }
+                port.rawHeader[port.rawHeaderLen++] = *(p - 1);
+                port.header[port.headerLen++] = byte;
+
+                if (port.headerLen == MAX_HEADER_SIZE) {
+                    decide(sourceId, port);
+                    if (port.local) {
+                        ok &= eventMsg.process(sourceId, port.rawHeader, port.rawHeaderLen);
+                    }
+                    port.phase = Phase::BODY;
+                }
+                break;
+            }
+
+            case Phase::BODY: {
+                // A stuffed body never contains a raw SOH or EOT, so no unstuffing is needed
+                const uint8_t* q = p;
+                while (q < end && *q != EOT && *q != SOH) q++;
+                bool complete = (q < end && *q == EOT);
+                const uint8_t* sliceEnd = complete ? q + 1 : q;
+                size_t sliceLen = sliceEnd - p;
+
+                if (port.local && sliceLen > 0) {
+                    ok &= eventMsg.process(sourceId, p, sliceLen);
+                }
+                if (port.target != Target::NONE) {
+                    if (port.frame.size() + sliceLen > FORWARD_MAX_FRAME) {
+                        stats.oversize++;
+                        port.target = Target::NONE;
+                        port.frame.clear();
+                    } else {
+                        port.frame.insert(port.frame.end(), p, sliceEnd);
+                    }
+                }
+                p = sliceEnd;
+
+                if (complete) {
+                    emit(sourceId, port);
+                    port.phase = Phase::IDLE;
+                } else if (q < end) {
+                    // Raw SOH inside a body: the frame was cut short, resync on it
+                    port.frame.clear();
+                    port.phase = Phase::IDLE;
+                }
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+void EventForwarder::decide(EventSourceId sourceId, PortState& port) {
+    uint8_t sender = port.header[0];
+    uint8_t receiver = port.header[1];
+    uint8_t group = port.header[2];
+    uint8_t flags = port.header[3];
+
+    port.local = false;
+    port.target = Target::NONE;
+    port.rule = 0;
+    port.frame.clear();
+
+    // Learn the return path, including for frames we never parse
+    if (sender != BROADCAST_SENDER) {
+        eventMsg.learnRoute(sender, sourceId);
+    }
+
+    for (size_t i = 0; i < rules.size(); i++) {
+        const ForwardRule& rule = rules[i];
+        if (rule.ingress != FORWARD_ANY && rule.ingress != sourceId) continue;
+        if (rule.receiverId != FORWARD_ANY && rule.receiverId != receiver) continue;
+        if (rule.groupId != FORWARD_ANY && rule.groupId != group) continue;
+        port.rule = i;
+        port.local = rule.deliverLocal;
+        port.target = Target::RULE;
+        break;
+    }
+
+    if (port.target != Target::RULE) {
+        EventSourceId route = (receiver != BROADCAST_ADDR) ? eventMsg.getRoute(receiver) : 0;
+        if (receiver == eventMsg.getAddr()) {
+            port.local = true;
+        } else if (route != 0) {
+            // Peers on the ingress link already heard it
+            if (route != sourceId) {
+                port.target = Target::ROUTE;
+                port.routeSource = route;
+            }
+        } else {
+            port.local = true;
+            port.target = Target::FLOOD;
+        }
+    }
+
+    if (port.target != Target::NONE) {
+        uint8_t hops = (flags & EVENT_FLAG_HOPS_MASK) >> EVENT_FLAG_HOPS_SHIFT;
+        if (hops >= EVENT_MAX_HOPS) {
+            stats.hopLimited++;
+            port.target = Target::NONE;
+        } else {
+            // Only the header is rebuilt; the body is copied through verbatim
+            uint8_t header[MAX_HEADER_SIZE];
+            memcpy(header, port.header, MAX_HEADER_SIZE);
+            header[3] = (flags & ~EVENT_FLAG_HOPS_MASK) | ((hops + 1) << EVENT_FLAG_HOPS_SHIFT);
+            port.frame.reserve(FORWARD_MAX_FRAME);
+            uint8_t stuffed[1 + MAX_HEADER_SIZE * 2] = {SOH};
+            size_t stuffedLen = 1 + EventMsg::ByteStuff(header, MAX_HEADER_SIZE, stuffed + 1, sizeof(stuffed) - 1);
+            port.frame.insert(port.frame.end(), stuffed, stuffed + stuffedLen);
+        }
+    }
+
+    if (port.local) {
+        stats.local++;
+    }
+}
+
+void EventForwarder::emit(EventSourceId sourceId, PortState& port) {
+    if (port.target == Target::NONE) return;
+
+    bool written = false;
+    const uint8_t* frame = port.frame.data();
+    size_t length = port.frame.size();
+
+    if (port.target == Target::ROUTE) {
+        written = eventMsg.writeFrameTo(port.routeSource, frame, length);
+    } else if (port.target == Target::RULE && port.rule < rules.size() && !rules[port.rule].egress.empty()) {
+        // Rules may change while a frame is in flight. If its rule is gone
+        // (clearRules()), the frame is flooded like a rule without egress.
+        for (EventSourceId egress : rules[port.rule].egress) {
+            if (egress != sourceId && eventMsg.writeFrameTo(egress, frame, length)) {
+                written = true;
+            }
+        }
+    } else {
+        // Flood every port except the one it came in on
+        for (EventSourceId egress : ports) {
+            if (egress != sourceId && eventMsg.writeFrameTo(egress, frame, length)) {
+                written = true;
+            }
+        }
+    }
+
+    if (written) {
+        stats.forwarded++;
+    }
+    port.frame.clear();
+}
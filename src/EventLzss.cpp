@@ -0,0 +1,100 @@
+#include "EventLzss.h"
+
+namespace {
+
+const uint16_t NONE = 0xFFFF;
+
+inline uint32_t hash3(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - EVENT_LZSS_HASH_BITS);
+}
+
+} // namespace
+
+size_t EventLzss::compress(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen) {
+    // Positions are stored in 16 bits
+    if (inputLen == 0 || inputLen >= NONE) return 0;
+
+    uint16_t head[1 << EVENT_LZSS_HASH_BITS];
+    for (size_t i = 0; i < (1u << EVENT_LZSS_HASH_BITS); i++) {
+        head[i] = NONE;
+    }
+
+    size_t outLen = 0;
+    size_t control = 0;
+    unsigned bit = 8;
+    size_t pos = 0;
+    while (pos < inputLen) {
+        if (bit == 8) {
+            if (outLen >= outputMaxLen) return 0;
+            control = outLen;
+            output[outLen++] = 0;
+            bit = 0;
+        }
+
+        // One candidate per hash: the last position these three bytes were seen
+        size_t matchLen = 0;
+        size_t distance = 0;
+        if (pos + EVENT_LZSS_MIN_MATCH <= inputLen) {
+            uint32_t h = hash3(input + pos);
+            uint16_t candidate = head[h];
+            head[h] = (uint16_t)pos;
+            if (candidate != NONE && pos - candidate <= EVENT_LZSS_WINDOW) {
+                size_t limit = inputLen - pos < EVENT_LZSS_MAX_MATCH ? inputLen - pos : EVENT_LZSS_MAX_MATCH;
+                while (matchLen < limit && input[candidate + matchLen] == input[pos + matchLen]) {
+                    matchLen++;
+                }
+                distance = pos - candidate;
+            }
+        }
+
+        if (matchLen >= EVENT_LZSS_MIN_MATCH) {
+            if (outLen + 2 > outputMaxLen) return 0;
+            uint16_t token = (uint16_t)(((distance - 1) << 4) | (matchLen - EVENT_LZSS_MIN_MATCH));
+            output[outLen++] = (uint8_t)(token >> 8);
+            output[outLen++] = (uint8_t)(token & 0xFF);
+            // Index the positions the match covers so later matches can start there
+            for (size_t k = 1; k < matchLen; k++) {
+                if (pos + k + EVENT_LZSS_MIN_MATCH <= inputLen) {
+                    head[hash3(input + pos + k)] = (uint16_t)(pos + k);
+                }
+            }
+            pos += matchLen;
+        } else {
+            if (outLen >= outputMaxLen) return 0;
+            output[control] |= (uint8_t)(1 << bit);
+            output[outLen++] = input[pos++];
+        }
+        bit++;
+    }
+    return outLen;
+}
+
+size_t EventLzss::decompress(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen) {
+    size_t pos = 0;
+    size_t outLen = 0;
+    while (pos < inputLen) {
+        uint8_t control = input[pos++];
+        for (unsigned bit = 0; bit < 8 && pos < inputLen; bit++) {
+            if (control & (1 << bit)) {
+                if (outLen >= outputMaxLen) return 0;
+                output[outLen++] = input[pos++];
+                continue;
+            }
+
+            if (pos + 2 > inputLen) return 0;
+            uint16_t token = (uint16_t)((input[pos] << 8) | input[pos + 1]);
+            pos += 2;
+            size_t distance = (size_t)(token >> 4) + 1;
+            size_t length = (size_t)(token & 0x0F) + EVENT_LZSS_MIN_MATCH;
+            if (distance > outLen || outLen + length > outputMaxLen) return 0;
+            // Byte by byte: the source may overlap what we are writing
+            const uint8_t* from = output + outLen - distance;
+            for (size_t k = 0; k < length; k++) {
+                output[outLen + k] = from[k];
+            }
+            outLen += length;
+        }
+    }
+    return outLen;
+}
@@ -1,4 +1,6 @@
 #include "EventMsg.h"
+#include "EventNames.h"
+#include "EventLzss.h"
 #include <string.h>
 
 // Initialize static members
@@ -7,14 +9,70 @@ portMUX_TYPE ThreadSafeQueue::mux = portMUX_INITIALIZER_UNLOCKED;
 // Define the global source queue manager
 SourceQueueManager sourceManager;
 
+namespace {
+
+// Holds EventMsg::txLock for the rest of the scope
+class TxGuard {
+public:
+    explicit TxGuard(SemaphoreHandle_t lock) : lock(lock) {
+        if (lock != nullptr) xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    }
+    ~TxGuard() {
+        if (lock != nullptr) xSemaphoreGiveRecursive(lock);
+    }
+private:
+    SemaphoreHandle_t lock;
+};
+
+// Per-thread encode buffer for send(), so concurrent senders never share
+// one and steady-state sends don't allocate. A send nested inside a
+// transport callback gets a buffer of its own. Not freed when a task exits.
+struct SendScratch {
+    PSRAMVector<uint8_t> frame;
+    bool inUse = false;
+};
+thread_local SendScratch sendScratch;
+
+// Per-thread buffer for a compressed payload. Only used inside
+// encodeFrame(), which never re-enters itself once it has compressed.
+thread_local PSRAMVector<uint8_t> packScratch;
+
+class ScratchLease {
+public:
+    ScratchLease() : owned(!sendScratch.inUse) {
+        if (owned) sendScratch.inUse = true;
+    }
+    ~ScratchLease() {
+        if (owned) sendScratch.inUse = false;
+    }
+    PSRAMVector<uint8_t>& frame() { return owned ? sendScratch.frame : local; }
+private:
+    bool owned;
+    PSRAMVector<uint8_t> local;
+};
+
+// Per-thread payload copies for local delivery, one per nesting level, so
+// a handler that sends to this node again does not overwrite the payload
+// its caller's handlers are still reading
+struct LocalScratch {
+    PSRAMVector<uint8_t> data[MAX_LOCAL_DELIVERY_DEPTH];
+    size_t depth = 0;
+};
+thread_local LocalScratch localScratch;
+
+class LocalDepth {
+public:
+    LocalDepth() { localScratch.depth++; }
+    ~LocalDepth() { localScratch.depth--; }
+};
+
+} // namespace
+
 bool EventMsg::init(WriteCallback cb) {
     setWriteCallback(cb);
     
     // Ensure at least one source exists
     ensureDefaultSource();
-    
-    // No need to initialize fixed array - dynamic map handles this
-    unhandledHandler = nullptr;
     return true;
 }
 
@@ -27,106 +85,163 @@ void EventMsg::setGroup(uint8_t addr) {
 }
 
 bool EventMsg::registerDispatcher(const char* deviceName, const EventHeader& header, EventDispatcherCallback cb) {
-    for (const auto& dispatcher : dispatchers) {
-        if (dispatcher.deviceName == deviceName) {
-            return false;
+    return handlers.update([&](HandlerTable& table) {
+        for (const auto& dispatcher : table.dispatchers) {
+            if (dispatcher.deviceName == deviceName) {
+                return false;
+            }
         }
-    }
 
-    EventDispatcherInfo dispatcher{
-        std::string(deviceName),
-        cb,
-        header.receiverId,
-        header.senderId,
-        header.groupId
-    };
-    dispatchers.push_back(dispatcher);
-    return true;
+        EventDispatcherInfo dispatcher{
+            std::string(deviceName),
+            cb,
+            header.receiverId,
+            header.senderId,
+            header.groupId
+        };
+        table.dispatchers.push_back(dispatcher);
+        return true;
+    });
 }
 
 bool EventMsg::unregisterDispatcher(const char* deviceName) {
-    for (auto it = dispatchers.begin(); it != dispatchers.end(); ++it) {
-        if (it->deviceName == deviceName) {
-            dispatchers.erase(it);
-            return true;
+    return handlers.update([&](HandlerTable& table) {
+        for (auto it = table.dispatchers.begin(); it != table.dispatchers.end(); ++it) {
+            if (it->deviceName == deviceName) {
+                table.dispatchers.erase(it);
+                return true;
+            }
         }
-    }
-    return false;
+        return false;
+    });
 }
 
 bool EventMsg::registerRawHandler(const char* deviceName, const EventHeader& header, RawDataCallback cb) {
-    for (const auto& handler : rawHandlers) {
-        if (handler.deviceName == deviceName) {
-            return false;
+    return handlers.update([&](HandlerTable& table) {
+        for (const auto& handler : table.rawHandlers) {
+            if (handler.deviceName == deviceName) {
+                return false;
+            }
         }
-    }
-    
-    RawDataHandler handler{
-        std::string(deviceName),
-        cb,
-        header.receiverId,
-        header.senderId,
-        header.groupId
-    };
-    rawHandlers.push_back(handler);
-    return true;
+
+        RawDataHandler handler{
+            std::string(deviceName),
+            cb,
+            header.receiverId,
+            header.senderId,
+            header.groupId
+        };
+        table.rawHandlers.push_back(handler);
+        return true;
+    });
 }
 
 bool EventMsg::unregisterRawHandler(const char* deviceName) {
-    for (auto it = rawHandlers.begin(); it != rawHandlers.end(); ++it) {
-        if (it->deviceName == deviceName) {
-            rawHandlers.erase(it);
-            return true;
+    return handlers.update([&](HandlerTable& table) {
+        for (auto it = table.rawHandlers.begin(); it != table.rawHandlers.end(); ++it) {
+            if (it->deviceName == deviceName) {
+                table.rawHandlers.erase(it);
+                return true;
+            }
         }
-    }
-    return false;
+        return false;
+    });
 }
 
 void EventMsg::setUnhandledHandler(const char* deviceName, const EventHeader& header, EventDispatcherCallback cb) {
-    if (unhandledHandler == nullptr) {
-        unhandledHandler = new EventDispatcherInfo;
+    handlers.update([&](HandlerTable& table) {
+        table.unhandled.deviceName = std::string(deviceName);
+        table.unhandled.callback = cb;
+        table.unhandled.receiverId = header.receiverId;
+        table.unhandled.senderId = header.senderId;
+        table.unhandled.groupId = header.groupId;
+        return true;
+    });
+}
+
+bool EventMsg::registerReceiveFilter(const char* name, ReceiveFilterCallback cb) {
+    return handlers.update([&](HandlerTable& table) {
+        for (const auto& filter : table.receiveFilters) {
+            if (filter.name == name) {
+                return false;
+            }
+        }
+
+        ReceiveFilter filter{
+            std::string(name),
+            cb
+        };
+        table.receiveFilters.push_back(filter);
+        return true;
+    });
+}
+
+bool EventMsg::unregisterReceiveFilter(const char* name) {
+    return handlers.update([&](HandlerTable& table) {
+        for (auto it = table.receiveFilters.begin(); it != table.receiveFilters.end(); ++it) {
+            if (it->name == name) {
+                table.receiveFilters.erase(it);
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+bool EventMsg::runReceiveFilters(EventSourceId sourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+    RcuPtr<HandlerTable>::Reader table(handlers);
+    for (const auto& filter : table->receiveFilters) {
+        if (filter.callback && !filter.callback(sourceId, eventName, data, length, header)) {
+            return false;
+        }
     }
-    unhandledHandler->deviceName = std::string(deviceName);
-    unhandledHandler->callback = cb;
-    unhandledHandler->receiverId = header.receiverId;
-    unhandledHandler->senderId = header.senderId;
-    unhandledHandler->groupId = header.groupId;
+    return true;
+}
+
+void EventMsg::deliver(const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+    processCallbacks(eventName, data, length, header);
 }
 
 void EventMsg::processAllSources() {
     // Check if any sources exist before processing
-    if (sourceManager.getSourceCount() == 0) {
+    if (sourceQueues->getSourceCount() == 0) {
         DEBUG_PRINT("processAllSources: No sources to process");
         return;
     }
     
-    sourceManager.processAll([this](uint8_t sourceId, uint8_t* data, size_t length) {
+    sourceQueues->processAll([this](EventSourceId sourceId, uint8_t* data, size_t length) {
         // No bounds checking needed - dynamic map handles any source ID
         this->process(sourceId, data, length);
     });
 }
 
+// Payloads are mostly plain bytes, so eight are tested at once: a word
+// with no byte below 0x20 (every control character is) is copied as it is.
 size_t EventMsg::ByteStuff(const uint8_t* input, size_t inputLen, uint8_t* output, size_t outputMaxLen) {
+    const uint64_t ones = 0x0101010101010101ULL;
     size_t outputLen = 0;
-    const uint8_t controlChars[] = {SOH, STX, US, EOT, ESC};
-    const size_t numControlChars = sizeof(controlChars);
-
-    for(size_t i = 0; i < inputLen; i++) {
-        bool needsStuffing = false;
-        for(size_t j = 0; j < numControlChars; j++) {
-            if(input[i] == controlChars[j]) {
-                needsStuffing = true;
-                break;
+    size_t i = 0;
+
+    while(i < inputLen) {
+        if(i + 8 <= inputLen && outputLen + 8 <= outputMaxLen) {
+            uint64_t word;
+            memcpy(&word, input + i, 8);
+            if(((word - ones * 0x20) & ~word & ones * 0x80) == 0) {
+                memcpy(output + outputLen, &word, 8);
+                outputLen += 8;
+                i += 8;
+                continue;
             }
         }
 
-        if(needsStuffing) {
+        uint8_t b = input[i++];
+        if(b == SOH || b == STX || b == US || b == EOT || b == ESC) {
             if(outputLen + 2 > outputMaxLen) return 0;
             output[outputLen++] = ESC;
-            output[outputLen++] = input[i] ^ 0x20;
+            output[outputLen++] = b ^ 0x20;
         } else {
             if(outputLen + 1 > outputMaxLen) return 0;
-            output[outputLen++] = input[i];
+            output[outputLen++] = b;
         }
     }
     return outputLen;
@@ -179,66 +294,414 @@ size_t EventMsg::send(const char* name, const char* data, uint8_t receiverId, ui
 }
 
 size_t EventMsg::send(const char* name, const char* data, const EventHeader& header) {
-    PSRAMVector<uint8_t> tempBuf;
-    PSRAMVector<uint8_t> msgBuf;
-    tempBuf.reserve(MAX_EVENT_NAME_SIZE * 2);
-    msgBuf.reserve(MAX_EVENT_DATA_SIZE * 2);
-    
-    msgBuf.push_back(SOH);
+    size_t length = strlen(data);
+    if(length == 0 || length >= MAX_EVENT_DATA_SIZE) return 0;
+    return send(name, (const uint8_t*)data, length, header);
+}
+
+size_t EventMsg::send(const char* name, const uint8_t* data, size_t length, const EventHeader& header) {
+    // Responses keep the request's msgId so the caller can correlate them
+    uint16_t msgId = (header.flags & EVENT_FLAG_RESPONSE) ? header.msgId : nextMsgId();
+
+    // For this node only: the size it would have had, without framing
+    if(deliverLocal(name, data, length, header, msgId)) {
+        return MAX_HEADER_SIZE + strlen(name) + length;
+    }
+
+    ScratchLease scratch;
+    PSRAMVector<uint8_t>& msgBuf = scratch.frame();
+    size_t frameLen = encodeFrame(name, data, length, header, msgId, msgBuf);
+    if(frameLen == 0) return 0;
+
+    if(writeFrame(msgBuf.data(), frameLen, header.receiverId)) {
+        return frameLen;
+    }
+    return 0;
+}
+
+size_t EventMsg::multicast(const EventSourceId* sourceIds, size_t count, const char* name,
+                           const uint8_t* data, size_t length, const EventHeader& header) {
+    uint16_t msgId = (header.flags & EVENT_FLAG_RESPONSE) ? header.msgId : nextMsgId();
+
+    ScratchLease scratch;
+    PSRAMVector<uint8_t>& msgBuf = scratch.frame();
+    size_t frameLen = encodeFrame(name, data, length, header, msgId, msgBuf);
+    if(frameLen == 0) return 0;
+
+    TxGuard guard(txLock);
+    bool written = false;
+    for(size_t i = 0; i < count; i++) {
+        if(writeFrameTo(sourceIds[i], msgBuf.data(), frameLen)) {
+            written = true;
+        }
+    }
+    return written ? frameLen : 0;
+}
+
+bool EventMsg::deliverLocal(const char* name, const uint8_t* data, size_t length, const EventHeader& header, uint16_t msgId) {
+    if(!localDelivery) return false;
+    bool toUs = header.receiverId == localAddr;
+    bool toOurGroup = header.receiverId == BROADCAST_ADDR && groupAddr != 0 && header.groupId == groupAddr;
+    if(!toUs && !toOurGroup) return false;
+
+    size_t nameLen = strlen(name);
+    if(nameLen == 0 || nameLen >= MAX_EVENT_NAME_SIZE || length > MAX_EVENT_DATA_SIZE) return false;
+
+    // What the parser would have produced: the msgId filled in and the
+    // encoding flags already undone
+    EventHeader local = header;
+    local.msgId = msgId;
+    local.flags &= ~(EVENT_FLAG_COMPACT_ID | EVENT_FLAG_COMPRESSED);
+    if((local.flags & EVENT_FLAG_CRC_MASK) == 0) {
+        local.flags |= crcMode;
+    }
+
+    // Too deep: a handler keeps sending to this node. Let it go out
+    // framed, as without local delivery, rather than grow the stack.
+    if(localScratch.depth >= MAX_LOCAL_DELIVERY_DEPTH) {
+        DEBUG_PRINT("deliverLocal: nested %u deep, sending '%s' framed", (unsigned)localScratch.depth, name);
+        return false;
+    }
+
+    // Handlers may read the payload as a string, as they can from the parser
+    PSRAMVector<uint8_t>& copy = localScratch.data[localScratch.depth];
+    copy.resize(length + 1);
+    if(length != 0) memcpy(copy.data(), data, length);
+    copy[length] = '\0';
+
+    LocalDepth nested;
+    processCallbacks(name, copy.data(), length, local);
+    return toUs;
+}
+
+uint16_t EventMsg::nextMsgId() {
+    return msgIdCounter.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool EventMsg::writeFrame(const uint8_t* frame, size_t length, uint8_t receiverId) {
+    TxGuard guard(txLock);
+    if(sourceTransports.empty()) {
+        if(!writeCallback || isTransportPaused(0)) return false;
+        return transmit(0, writeCallback, frame, length);
+    }
+
+    // Unicast to a peer we have heard from: its link only
+    if(receiverId != BROADCAST_ADDR && routes[receiverId] != 0) {
+        auto it = sourceTransports.find(routes[receiverId]);
+        if(it != sourceTransports.end() && it->second) {
+            if(isTransportPaused(it->first)) return false;
+            return transmit(it->first, it->second, frame, length);
+        }
+    }
+
+    // Broadcast or unknown destination: flood every link that isn't paused
+    bool written = false;
+    for(auto it = sourceTransports.begin(); it != sourceTransports.end(); ++it) {
+        if(it->second && !isTransportPaused(it->first) && transmit(it->first, it->second, frame, length)) {
+            written = true;
+        }
+    }
+    if(writeCallback && !isTransportPaused(0) && transmit(0, writeCallback, frame, length)) {
+        written = true;
+    }
+    return written;
+}
+
+bool EventMsg::transmit(EventSourceId sourceId, const WriteCallback& transport, const uint8_t* frame, size_t length) {
+    if(!transport(const_cast<uint8_t*>(frame), length)) return false;
+    if(captureTap) {
+        captureTap(EVENT_CAPTURE_TX, sourceId, frame, length);
+    }
+    return true;
+}
+
+bool EventMsg::writeFrameTo(EventSourceId sourceId, const uint8_t* frame, size_t length, bool urgent) {
+    TxGuard guard(txLock);
+    if(!urgent && isTransportPaused(sourceId)) return false;
+    if(sourceId == 0) {
+        return writeCallback && transmit(0, writeCallback, frame, length);
+    }
+    auto it = sourceTransports.find(sourceId);
+    if(it == sourceTransports.end() || !it->second) return false;
+    return transmit(sourceId, it->second, frame, length);
+}
+
+void EventMsg::pauseTransport(EventSourceId sourceId, uint32_t ms) {
+    TxGuard guard(txLock);
+    pausedUntil[sourceId] = millis() + ms;
+}
+
+void EventMsg::resumeTransport(EventSourceId sourceId) {
+    TxGuard guard(txLock);
+    pausedUntil.erase(sourceId);
+}
+
+bool EventMsg::isTransportPaused(EventSourceId sourceId) {
+    TxGuard guard(txLock);
+    if(pausedUntil.empty()) return false;
+    auto it = pausedUntil.find(sourceId);
+    if(it == pausedUntil.end()) return false;
+    if((int32_t)(millis() - it->second) >= 0) {
+        pausedUntil.erase(it);
+        return false;
+    }
+    return true;
+}
+
+void EventMsg::setWriteCallback(WriteCallback cb) {
+    TxGuard guard(txLock);
+    writeCallback = cb;
+}
+
+void EventMsg::setSourceTransport(EventSourceId sourceId, WriteCallback cb) {
+    TxGuard guard(txLock);
+    sourceTransports[sourceId] = cb;
+}
+
+bool EventMsg::hasSourceTransport(EventSourceId sourceId) const {
+    TxGuard guard(txLock);
+    return sourceTransports.count(sourceId) != 0;
+}
+
+void EventMsg::removeSourceTransport(EventSourceId sourceId) {
+    TxGuard guard(txLock);
+    sourceTransports.erase(sourceId);
+    pausedUntil.erase(sourceId);
+    forgetRoutesVia(sourceId);
+}
+
+void EventMsg::forgetRoutesVia(EventSourceId sourceId) {
+    for(size_t addr = 0; addr < 256; addr++) {
+        if(routes[addr] == sourceId) {
+            routes[addr] = 0;
+        }
+    }
+}
+
+void EventMsg::removeSource(EventSourceId sourceId) {
+    removeSourceTransport(sourceId);
+    sourceStates.erase(sourceId);
+    sourceQueues->removeSource(sourceId);
+}
+
+size_t EventMsg::encodeFrame(const char* name, const uint8_t* data, size_t length,
+                             const EventHeader& header, uint16_t msgId, PSRAMVector<uint8_t>& msgBuf) {
+    size_t nameLen = strlen(name);
+    if(nameLen == 0 || nameLen >= MAX_EVENT_NAME_SIZE) return 0;
+    if(length > MAX_EVENT_DATA_SIZE) return 0;
+
+    // Apply the instance CRC mode unless the header picks one itself
+    uint8_t flags = header.flags & ~(EVENT_FLAG_COMPACT_ID | EVENT_FLAG_COMPRESSED);
+    if ((flags & EVENT_FLAG_CRC_MASK) == 0) {
+        flags |= crcMode;
+    }
+    if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC_MASK) return 0;
+
+    // A name with a dictionary ID goes out as the ID (see EventNames)
+    const uint8_t* nameBytes = (const uint8_t*)name;
+    uint8_t compactId[2];
+    if (nameTable != nullptr) {
+        size_t idLen = nameTable->encode(name, header, compactId);
+        if (idLen != 0) {
+            nameBytes = compactId;
+            nameLen = idLen;
+            flags |= EVENT_FLAG_COMPACT_ID;
+        }
+    }
+
+    // Compress on request or above the threshold, if it saves space
+    bool compress = (header.flags & EVENT_FLAG_COMPRESSED) || (compressThreshold != 0 && length >= compressThreshold);
+    if (compress && length > 1) {
+        if (packScratch.size() < MAX_EVENT_DATA_SIZE) {
+            packScratch.resize(MAX_EVENT_DATA_SIZE);
+        }
+        size_t packedLen = EventLzss::compress(data, length, packScratch.data(), length - 1);
+        if (packedLen != 0) {
+            data = packScratch.data();
+            length = packedLen;
+            flags |= EVENT_FLAG_COMPRESSED;
+        }
+    }
 
     uint8_t headerBytes[] = {
         header.senderId,
         header.receiverId,
         header.groupId,
-        header.flags,
-        (uint8_t)(msgIdCounter >> 8),
-        (uint8_t)(msgIdCounter & 0xFF)
+        flags,
+        (uint8_t)(msgId >> 8),
+        (uint8_t)(msgId & 0xFF)
     };
-    msgIdCounter++;
 
-    tempBuf.resize(MAX_EVENT_NAME_SIZE * 2);
-    size_t stuffedLen = ByteStuff(headerBytes, sizeof(headerBytes), tempBuf.data(), tempBuf.size());
-    if(stuffedLen == 0) return 0;
-    
-    msgBuf.insert(msgBuf.end(), tempBuf.begin(), tempBuf.begin() + stuffedLen);
-    msgBuf.push_back(STX);
+    // CRC covers header, event name, the US separator and event data.
+    // Hop count bits are left out so gateways can bump them in flight.
+    uint8_t crcHeader[sizeof(headerBytes)];
+    memcpy(crcHeader, headerBytes, sizeof(headerBytes));
+    crcHeader[3] &= ~EVENT_FLAG_HOPS_MASK;
+
+    uint8_t trailer[EVENT_CRC_MAX_SIZE];
+    size_t trailerLen = 0;
+    if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC16) {
+        uint16_t crc = EventCrc::crc16(EVENT_CRC16_INIT, crcHeader, sizeof(crcHeader));
+        crc = EventCrc::crc16(crc, nameBytes, nameLen);
+        crc = EventCrc::crc16Update(crc, US);
+        crc = EventCrc::crc16(crc, data, length);
+        trailer[trailerLen++] = (uint8_t)(crc >> 8);
+        trailer[trailerLen++] = (uint8_t)(crc & 0xFF);
+    } else if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC32) {
+        uint32_t crc = EventCrc::crc32(EVENT_CRC32_INIT, crcHeader, sizeof(crcHeader));
+        crc = EventCrc::crc32(crc, nameBytes, nameLen);
+        crc = EventCrc::crc32Update(crc, US);
+        crc = EventCrc::crc32Final(EventCrc::crc32(crc, data, length));
+        for (int i = 0; i < 4; i++) {
+            trailer[trailerLen++] = (uint8_t)(crc >> (8 * i));
+        }
+    }
 
-    PSRAMVector<uint8_t> eventNameBytes(MAX_EVENT_NAME_SIZE);
-    size_t eventNameLen = StringToBytes(name, eventNameBytes.data(), eventNameBytes.size());
-    if(eventNameLen == 0) return 0;
+    // Size for the worst case (every byte stuffed) so stuffing cannot fail
+    msgBuf.resize(4 + (sizeof(headerBytes) + nameLen + length + trailerLen) * 2);
+    uint8_t* out = msgBuf.data();
+    size_t outLen = 0;
+
+    out[outLen++] = SOH;
+    outLen += ByteStuff(headerBytes, sizeof(headerBytes), out + outLen, msgBuf.size() - outLen);
+    out[outLen++] = STX;
+    outLen += ByteStuff(nameBytes, nameLen, out + outLen, msgBuf.size() - outLen);
+    out[outLen++] = US;
+    outLen += ByteStuff(data, length, out + outLen, msgBuf.size() - outLen);
+    outLen += ByteStuff(trailer, trailerLen, out + outLen, msgBuf.size() - outLen);
+    out[outLen++] = EOT;
+
+    msgBuf.resize(outLen);
+    return outLen;
+}
 
-    stuffedLen = ByteStuff(eventNameBytes.data(), eventNameLen, tempBuf.data(), tempBuf.size());
-    if(stuffedLen == 0) return 0;
-    
-    msgBuf.insert(msgBuf.end(), tempBuf.begin(), tempBuf.begin() + stuffedLen);
-    msgBuf.push_back(US);
+PreparedEvent::PreparedEvent(EventMsg& eventMsg, const char* name, const EventHeader& header)
+    : eventMsg(eventMsg) {
+    prepare(name, header);
+}
 
-    PSRAMVector<uint8_t> eventDataBytes(MAX_EVENT_DATA_SIZE);
-    size_t eventDataLen = StringToBytes(data, eventDataBytes.data(), eventDataBytes.size());
-    if(eventDataLen == 0) return 0;
+bool PreparedEvent::prepare(const char* eventName, const EventHeader& eventHeader) {
+    suffix.clear();
+    name.clear();
+    localName[0] = '\0';
+    header = eventHeader;
 
-    tempBuf.resize(msgBuf.capacity() - msgBuf.size() - 1);
-    stuffedLen = ByteStuff(eventDataBytes.data(), eventDataLen, tempBuf.data(), tempBuf.size());
-    if(stuffedLen == 0) return 0;
-    
-    msgBuf.insert(msgBuf.end(), tempBuf.begin(), tempBuf.begin() + stuffedLen);
-    msgBuf.push_back(EOT);
+    size_t nameLen = strlen(eventName);
+    if(nameLen == 0 || nameLen >= MAX_EVENT_NAME_SIZE) return false;
+
+    // Same rules as encodeFrame(), without compression
+    flags = header.flags & ~(EVENT_FLAG_COMPACT_ID | EVENT_FLAG_COMPRESSED);
+    if ((flags & EVENT_FLAG_CRC_MASK) == 0) {
+        flags |= eventMsg.getCrcMode();
+    }
+    if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC_MASK) return false;
+
+    memcpy(localName, eventName, nameLen + 1);
+    name.assign((const uint8_t*)eventName, (const uint8_t*)eventName + nameLen);
+    if (EventNames* table = eventMsg.getNameTable()) {
+        uint8_t compactId[2];
+        size_t idLen = table->encode(eventName, header, compactId);
+        if (idLen != 0) {
+            name.assign(compactId, compactId + idLen);
+            flags |= EVENT_FLAG_COMPACT_ID;
+        }
+    }
 
-    if(writeCallback) {
-        if(writeCallback(msgBuf.data(), msgBuf.size())) {
-            return msgBuf.size();
+    uint8_t headerBytes[] = {header.senderId, header.receiverId, header.groupId, flags};
+    prefix[0] = SOH;
+    prefixLen = 1 + EventMsg::ByteStuff(headerBytes, sizeof(headerBytes), prefix + 1, sizeof(prefix) - 1);
+
+    suffix.resize(2 + name.size() * 2);
+    size_t suffixLen = 0;
+    suffix[suffixLen++] = STX;
+    suffixLen += EventMsg::ByteStuff(name.data(), name.size(), suffix.data() + suffixLen, suffix.size() - suffixLen);
+    suffix[suffixLen++] = US;
+    suffix.resize(suffixLen);
+
+    // Hop count bits are left out of the CRC, as in encodeFrame()
+    headerBytes[3] &= ~EVENT_FLAG_HOPS_MASK;
+    if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC16) {
+        crcSeed = EventCrc::crc16(EVENT_CRC16_INIT, headerBytes, sizeof(headerBytes));
+    } else if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC32) {
+        crcSeed = EventCrc::crc32(EVENT_CRC32_INIT, headerBytes, sizeof(headerBytes));
+    }
+    return true;
+}
+
+size_t PreparedEvent::encode(const uint8_t* data, size_t length, uint16_t msgId, PSRAMVector<uint8_t>& msgBuf) const {
+    if(!isValid() || length > MAX_EVENT_DATA_SIZE) return 0;
+
+    uint8_t msgIdBytes[] = {(uint8_t)(msgId >> 8), (uint8_t)(msgId & 0xFF)};
+    uint8_t trailer[EVENT_CRC_MAX_SIZE];
+    size_t trailerLen = 0;
+    if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC16) {
+        uint16_t crc = EventCrc::crc16((uint16_t)crcSeed, msgIdBytes, sizeof(msgIdBytes));
+        crc = EventCrc::crc16(crc, name.data(), name.size());
+        crc = EventCrc::crc16Update(crc, US);
+        crc = EventCrc::crc16(crc, data, length);
+        trailer[trailerLen++] = (uint8_t)(crc >> 8);
+        trailer[trailerLen++] = (uint8_t)(crc & 0xFF);
+    } else if ((flags & EVENT_FLAG_CRC_MASK) == EVENT_FLAG_CRC32) {
+        uint32_t crc = EventCrc::crc32(crcSeed, msgIdBytes, sizeof(msgIdBytes));
+        crc = EventCrc::crc32(crc, name.data(), name.size());
+        crc = EventCrc::crc32Update(crc, US);
+        crc = EventCrc::crc32Final(EventCrc::crc32(crc, data, length));
+        for (int i = 0; i < 4; i++) {
+            trailer[trailerLen++] = (uint8_t)(crc >> (8 * i));
         }
     }
+
+    msgBuf.resize(prefixLen + sizeof(msgIdBytes) * 2 + suffix.size() + (length + trailerLen) * 2 + 1);
+    uint8_t* out = msgBuf.data();
+    size_t outLen = 0;
+
+    memcpy(out, prefix, prefixLen);
+    outLen += prefixLen;
+    outLen += EventMsg::ByteStuff(msgIdBytes, sizeof(msgIdBytes), out + outLen, msgBuf.size() - outLen);
+    memcpy(out + outLen, suffix.data(), suffix.size());
+    outLen += suffix.size();
+    outLen += EventMsg::ByteStuff(data, length, out + outLen, msgBuf.size() - outLen);
+    outLen += EventMsg::ByteStuff(trailer, trailerLen, out + outLen, msgBuf.size() - outLen);
+    out[outLen++] = EOT;
+
+    msgBuf.resize(outLen);
+    return outLen;
+}
+
+size_t PreparedEvent::send(const uint8_t* data, size_t length) const {
+    if(!isValid()) return 0;
+    uint16_t msgId = (header.flags & EVENT_FLAG_RESPONSE) ? header.msgId : eventMsg.nextMsgId();
+
+    if(eventMsg.deliverLocal(localName, data, length, header, msgId)) {
+        return MAX_HEADER_SIZE + strlen(localName) + length;
+    }
+
+    ScratchLease scratch;
+    PSRAMVector<uint8_t>& msgBuf = scratch.frame();
+    size_t frameLen = encode(data, length, msgId, msgBuf);
+    if(frameLen == 0) return 0;
+
+    if(eventMsg.writeFrame(msgBuf.data(), frameLen, header.receiverId)) {
+        return frameLen;
+    }
     return 0;
 }
 
-void EventMsg::resetState(uint8_t sourceId) {
+size_t PreparedEvent::send(const char* data) const {
+    size_t length = strlen(data);
+    if(length == 0 || length >= MAX_EVENT_DATA_SIZE) return 0;
+    return send((const uint8_t*)data, length);
+}
+
+void EventMsg::resetState(EventSourceId sourceId) {
     // Create state if it doesn't exist, or reset existing state
     auto& state = sourceStates[sourceId];
     state.state = ProcessState::WAITING_FOR_SOH;
     state.currentBuffer = nullptr;
     state.bufferPos = 0;
     state.escapedMode = false;
+    state.crcMode = 0;
+    state.crc = 0;
     state.headerBuffer.clear();
     state.eventNameBuffer.clear();
     state.eventDataBuffer.clear();
@@ -268,14 +731,15 @@ bool EventMsg::isHandlerMatch(const EventHeader& header, uint8_t receiverId, uin
 
 void EventMsg::processCallbacks(const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
     bool eventHandled = false;
+    RcuPtr<HandlerTable>::Reader table(handlers);
 
-    for (const auto& handler : rawHandlers) {
+    for (const auto& handler : table->rawHandlers) {
         if (handler.callback && isHandlerMatch(header, handler.receiverId, handler.senderId, handler.groupId)) {
             handler.callback(handler.deviceName.c_str(), data, length);
         }
     }
 
-    for (const auto& dispatcher : dispatchers) {
+    for (const auto& dispatcher : table->dispatchers) {
         if (dispatcher.callback && isHandlerMatch(header, dispatcher.receiverId, dispatcher.senderId, dispatcher.groupId)) {
             dispatcher.callback(dispatcher.deviceName.c_str(), 
                              eventName,
@@ -286,31 +750,48 @@ void EventMsg::processCallbacks(const char* eventName, const uint8_t* data, size
         }
     }
 
-    if (!eventHandled && unhandledHandler && unhandledHandler->callback &&
-        isHandlerMatch(header, unhandledHandler->receiverId, unhandledHandler->senderId, unhandledHandler->groupId)) {
-        unhandledHandler->callback(unhandledHandler->deviceName.c_str(),
-                                 eventName,
-                                 (const char*)data,
-                                 length,
-                                 header);
+    const EventDispatcherInfo& unhandled = table->unhandled;
+    if (!eventHandled && unhandled.callback &&
+        isHandlerMatch(header, unhandled.receiverId, unhandled.senderId, unhandled.groupId)) {
+        unhandled.callback(unhandled.deviceName.c_str(),
+                           eventName,
+                           (const char*)data,
+                           length,
+                           header);
+    }
+}
+
+void EventMsg::crcUpdate(ProcessingState& state, uint8_t byte) {
+    if (state.crcMode == EVENT_FLAG_CRC16) {
+        state.crc = EventCrc::crc16Update((uint16_t)state.crc, byte);
+    } else if (state.crcMode == EVENT_FLAG_CRC32) {
+        state.crc = EventCrc::crc32Update(state.crc, byte);
     }
 }
 
-bool EventMsg::processNextByte(uint8_t sourceId, uint8_t byte) {
+bool EventMsg::processNextByte(EventSourceId sourceId, uint8_t byte) {
     // Get or create state for this source ID
     auto& state = sourceStates[sourceId];
     
+    // Unstuffed control characters are payload, never frame delimiters
+    bool escaped = false;
     if (state.escapedMode) {
         byte ^= 0x20;
         state.escapedMode = false;
+        escaped = true;
     } else if (byte == ESC) {
         state.escapedMode = true;
         return true;
     }
+
+    // A raw SOH always starts a new frame, even if the last one was cut short
+    if (byte == SOH && !escaped && state.state != ProcessState::WAITING_FOR_SOH) {
+        resetState(sourceId);
+    }
     
     switch (state.state) {
         case ProcessState::WAITING_FOR_SOH:
-            if (byte == SOH) {
+            if (byte == SOH && !escaped) {
                 state.state = ProcessState::READING_HEADER;
                 state.headerBuffer.clear();
                 state.bufferPos = 0;
@@ -331,12 +812,31 @@ bool EventMsg::processNextByte(uint8_t sourceId, uint8_t byte) {
                 DEBUG_PRINT("Header: sender=0x%02X, receiver=0x%02X, group=0x%02X, flags=0x%02X, msgId=%u",
                            sender, receiver, group, flags, msgId);
 
+                state.crcMode = flags & EVENT_FLAG_CRC_MASK;
+                if (state.crcMode == EVENT_FLAG_CRC_MASK) {
+                    return false;
+                }
+                if (state.crcMode == 0 && crcRequired) {
+                    // Skip the rest of this frame, resume at next SOH
+                    crcErrors++;
+                    resetState(sourceId);
+                    return true;
+                }
+                uint8_t crcHeader[MAX_HEADER_SIZE];
+                memcpy(crcHeader, state.headerBuffer.data(), MAX_HEADER_SIZE);
+                crcHeader[3] &= ~EVENT_FLAG_HOPS_MASK;
+                if (state.crcMode == EVENT_FLAG_CRC16) {
+                    state.crc = EventCrc::crc16(EVENT_CRC16_INIT, crcHeader, MAX_HEADER_SIZE);
+                } else if (state.crcMode == EVENT_FLAG_CRC32) {
+                    state.crc = EventCrc::crc32(EVENT_CRC32_INIT, crcHeader, MAX_HEADER_SIZE);
+                }
+
                 state.state = ProcessState::WAITING_FOR_STX;
             }
             break;
 
         case ProcessState::WAITING_FOR_STX:
-            if (byte == STX) {
+            if (byte == STX && !escaped) {
                 state.state = ProcessState::READING_EVENT_NAME;
                 state.eventNameBuffer.clear();
                 state.bufferPos = 0;
@@ -346,8 +846,9 @@ bool EventMsg::processNextByte(uint8_t sourceId, uint8_t byte) {
             break;
 
         case ProcessState::READING_EVENT_NAME:
-            if (byte == US) {
+            if (byte == US && !escaped) {
                 state.eventNameBuffer.push_back('\0');
+                crcUpdate(state, US);
                 DEBUG_PRINT("Event Name: %s (%d bytes)", state.eventNameBuffer.data(), state.bufferPos);
                 
                 state.state = ProcessState::READING_EVENT_DATA;
@@ -359,33 +860,95 @@ bool EventMsg::processNextByte(uint8_t sourceId, uint8_t byte) {
                 }
                 state.eventNameBuffer.push_back(byte);
                 state.bufferPos++;
+                crcUpdate(state, byte);
             }
             break;
 
         case ProcessState::READING_EVENT_DATA:
-            if (byte == EOT) {
+            if (byte == EOT && !escaped) {
+                // Trailer has already been fed through the CRC, check the residue
+                if (state.crcMode != 0) {
+                    size_t trailerLen = (state.crcMode == EVENT_FLAG_CRC16) ? 2 : 4;
+                    bool valid = state.bufferPos >= trailerLen &&
+                                 ((state.crcMode == EVENT_FLAG_CRC16)
+                                     ? state.crc == EVENT_CRC16_RESIDUE
+                                     : state.crc == EVENT_CRC32_RESIDUE);
+                    if (!valid) {
+                        DEBUG_PRINT("CRC mismatch, dropping frame");
+                        crcErrors++;
+                        resetState(sourceId);
+                        return true;
+                    }
+                    state.bufferPos -= trailerLen;
+                    state.eventDataBuffer.resize(state.bufferPos);
+                }
                 state.eventDataBuffer.push_back('\0');
                 
                 EventHeader msgHeader = {
                     state.headerBuffer[0],
                     state.headerBuffer[1],
                     state.headerBuffer[2],
-                    state.headerBuffer[3]
+                    state.headerBuffer[3],
+                    (uint16_t)((state.headerBuffer[4] << 8) | state.headerBuffer[5])
                 };
 
-                DEBUG_PRINT("Event Data: (%d bytes)", state.bufferPos);
-                processCallbacks((const char*)state.eventNameBuffer.data(),
-                               state.eventDataBuffer.data(),
-                               state.bufferPos,
-                               msgHeader);
+                // Remember which link this sender is reachable on
+                if (routeLearning && msgHeader.senderId != BROADCAST_SENDER) {
+                    routes[msgHeader.senderId] = sourceId;
+                }
+
+                // Swap a dictionary ID back for the name, so everything
+                // downstream sees an ordinary named event
+                if (msgHeader.flags & EVENT_FLAG_COMPACT_ID) {
+                    if (nameTable == nullptr || !nameTable->resolve(msgHeader, state.eventNameBuffer)) {
+                        DEBUG_PRINT("Unknown event ID, dropping frame");
+                        resetState(sourceId);
+                        return true;
+                    }
+                    msgHeader.flags &= ~EVENT_FLAG_COMPACT_ID;
+                }
+
+                // Handlers get the payload as it was sent. The CRC above
+                // covered the compressed bytes.
+                const uint8_t* payload = state.eventDataBuffer.data();
+                size_t payloadLen = state.bufferPos;
+                if (msgHeader.flags & EVENT_FLAG_COMPRESSED) {
+                    if (state.inflateBuffer.size() != MAX_EVENT_DATA_SIZE + 1) {
+                        state.inflateBuffer.resize(MAX_EVENT_DATA_SIZE + 1);
+                    }
+                    payloadLen = EventLzss::decompress(payload, payloadLen, state.inflateBuffer.data(), MAX_EVENT_DATA_SIZE);
+                    if (payloadLen == 0) {
+                        DEBUG_PRINT("Malformed compressed payload, dropping frame");
+                        resetState(sourceId);
+                        return true;
+                    }
+                    state.inflateBuffer[payloadLen] = '\0';
+                    payload = state.inflateBuffer.data();
+                    msgHeader.flags &= ~EVENT_FLAG_COMPRESSED;
+                }
+
+                DEBUG_PRINT("Event Data: (%d bytes)", payloadLen);
+                if (runReceiveFilters(sourceId,
+                                      (const char*)state.eventNameBuffer.data(),
+                                      payload,
+                                      payloadLen,
+                                      msgHeader)) {
+                    processCallbacks((const char*)state.eventNameBuffer.data(),
+                                   payload,
+                                   payloadLen,
+                                   msgHeader);
+                }
                 
                 resetState(sourceId);
             } else {
-                if (state.bufferPos >= MAX_EVENT_DATA_SIZE) {
+                size_t trailerLen = (state.crcMode == EVENT_FLAG_CRC16) ? 2 :
+                                    (state.crcMode == EVENT_FLAG_CRC32) ? 4 : 0;
+                if (state.bufferPos >= MAX_EVENT_DATA_SIZE + trailerLen) {
                     return false;
                 }
                 state.eventDataBuffer.push_back(byte);
                 state.bufferPos++;
+                crcUpdate(state, byte);
             }
             break;
     }
@@ -393,8 +956,11 @@ bool EventMsg::processNextByte(uint8_t sourceId, uint8_t byte) {
     return true;
 }
 
-bool EventMsg::process(uint8_t sourceId, const uint8_t* data, size_t len) {
+bool EventMsg::process(EventSourceId sourceId, const uint8_t* data, size_t len) {
     // No bounds checking needed - dynamic map handles any source ID
+    if (captureTap) {
+        captureTap(EVENT_CAPTURE_RX, sourceId, data, len);
+    }
     for (size_t i = 0; i < len; i++) {
         if (!processNextByte(sourceId, data[i])) {
             resetState(sourceId);
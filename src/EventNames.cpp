@@ -0,0 +1,243 @@
+#include "EventNames.h"
+#include <string.h>
+
+EventNames::EventNames(EventMsg& eventMsg, const Config& config)
+    : eventMsg(eventMsg), config(config) {
+    lock = xSemaphoreCreateMutex();
+}
+
+EventNames::~EventNames() {
+    end();
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool EventNames::begin(const char* name) {
+    if (!filterName.empty() || lock == nullptr) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+            return this->onFrame(eventName, data, length, header);
+        });
+    if (!registered) return false;
+    filterName = name;
+    eventMsg.setNameTable(this);
+    return true;
+}
+
+void EventNames::end() {
+    if (filterName.empty()) return;
+
+    if (eventMsg.getNameTable() == this) {
+        eventMsg.setNameTable(nullptr);
+    }
+    eventMsg.unregisterReceiveFilter(filterName.c_str());
+    filterName.clear();
+}
+
+size_t EventNames::findLocked(const char* name) const {
+    size_t low = 0;
+    size_t high = byName.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (strcmp(locals[byName[mid]].name.c_str(), name) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+uint16_t EventNames::compact(const char* name) {
+    size_t nameLen = strlen(name);
+    if (nameLen == 0 || nameLen >= MAX_EVENT_NAME_SIZE) return NAMES_MAX_ID + 1;
+    // The dictionary's own events must stay readable without it
+    if (strcmp(name, NAMES_DEF_EVENT) == 0 || strcmp(name, NAMES_REQ_EVENT) == 0) return NAMES_MAX_ID + 1;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t pos = findLocked(name);
+    uint16_t id;
+    if (pos < byName.size() && locals[byName[pos]].name == name) {
+        id = byName[pos];
+    } else if (locals.size() >= config.maxIds) {
+        id = NAMES_MAX_ID + 1;
+    } else {
+        id = (uint16_t)locals.size();
+        locals.push_back(Local());
+        locals.back().name = name;
+        byName.insert(byName.begin() + pos, id);
+    }
+    xSemaphoreGive(lock);
+    return id;
+}
+
+void EventNames::announce(uint8_t receiverId) {
+    std::vector<std::pair<uint16_t, std::string>> definitions;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (size_t id = 0; id < locals.size(); id++) {
+        locals[id].announced = true;
+        definitions.push_back(std::make_pair((uint16_t)id, locals[id].name));
+    }
+    xSemaphoreGive(lock);
+
+    for (const auto& definition : definitions) {
+        sendDefinition(definition.first, definition.second, receiverId);
+    }
+}
+
+bool EventNames::lookup(uint8_t senderId, uint16_t id, char* name, size_t size) const {
+    bool found = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = peers.find(senderId);
+    if (it != peers.end() && id < it->second.names.size() && !it->second.names[id].empty() && size > 0) {
+        strncpy(name, it->second.names[id].c_str(), size - 1);
+        name[size - 1] = '\0';
+        found = true;
+    }
+    xSemaphoreGive(lock);
+    return found;
+}
+
+EventNames::Stats EventNames::getStats() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Stats result = stats;
+    xSemaphoreGive(lock);
+    return result;
+}
+
+size_t EventNames::encode(const char* name, const EventHeader& header, uint8_t* out) {
+    // IDs are ours: a frame relayed for another sender keeps its name
+    if (header.senderId != eventMsg.getAddr()) return 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t pos = findLocked(name);
+    if (pos >= byName.size() || locals[byName[pos]].name != name) {
+        xSemaphoreGive(lock);
+        return 0;
+    }
+    uint16_t id = byName[pos];
+    size_t idLen = id < 0x80 ? 1 : 2;
+    bool announce = !locals[id].announced;
+    locals[id].announced = true;
+    stats.compactSent++;
+    stats.bytesSaved += locals[id].name.size() - idLen;
+    xSemaphoreGive(lock);
+
+    // Goes out ahead of the frame being encoded
+    if (announce) {
+        sendDefinition(id, name, BROADCAST_ADDR);
+    }
+
+    if (idLen == 1) {
+        out[0] = (uint8_t)id;
+    } else {
+        out[0] = (uint8_t)(0x80 | (id >> 8));
+        out[1] = (uint8_t)(id & 0xFF);
+    }
+    return idLen;
+}
+
+bool EventNames::resolve(const EventHeader& header, PSRAMVector<uint8_t>& name) {
+    // The parser leaves the field NUL-terminated
+    size_t length = name.empty() ? 0 : name.size() - 1;
+    uint16_t id = NAMES_MAX_ID + 1;
+    if (length == 1 && name[0] < 0x80) {
+        id = name[0];
+    } else if (length == 2 && (name[0] & 0x80)) {
+        id = (uint16_t)(((name[0] & 0x7F) << 8) | name[1]);
+    }
+
+    bool request = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (id <= NAMES_MAX_ID) {
+        auto it = peers.find(header.senderId);
+        if (it != peers.end() && id < it->second.names.size() && !it->second.names[id].empty()) {
+            // Names are shorter than MAX_EVENT_NAME_SIZE, which the buffer reserves
+            const std::string& known = it->second.names[id];
+            name.assign(known.begin(), known.end());
+            name.push_back('\0');
+            xSemaphoreGive(lock);
+            return true;
+        }
+
+        Peer& peer = peers[header.senderId];
+        uint32_t now = millis();
+        if (!peer.requested || now - peer.lastRequest >= config.requestInterval) {
+            peer.requested = true;
+            peer.lastRequest = now;
+            request = true;
+        }
+    }
+    stats.unknownDropped++;
+    xSemaphoreGive(lock);
+
+    if (request) {
+        sendRequest(header.senderId, id);
+    }
+    return false;
+}
+
+bool EventNames::onFrame(const char* eventName, const uint8_t* data, size_t length, const EventHeader& header) {
+    if (strcmp(eventName, NAMES_DEF_EVENT) == 0) {
+        if (length < 3 || length - 2 >= MAX_EVENT_NAME_SIZE) return false;
+        uint16_t id = (uint16_t)((data[0] << 8) | data[1]);
+        if (id >= config.maxIds) return false;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        Peer& peer = peers[header.senderId];
+        if (peer.names.size() <= id) {
+            peer.names.resize(id + 1);
+        }
+        peer.names[id].assign((const char*)data + 2, length - 2);
+        stats.definitionsReceived++;
+        xSemaphoreGive(lock);
+        return false;
+    }
+
+    if (strcmp(eventName, NAMES_REQ_EVENT) == 0) {
+        if (header.receiverId != eventMsg.getAddr() && header.receiverId != BROADCAST_ADDR) return false;
+        if (length < 2) {
+            announce(header.senderId);
+            return false;
+        }
+
+        uint16_t id = (uint16_t)((data[0] << 8) | data[1]);
+        std::string name;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (id < locals.size()) {
+            name = locals[id].name;
+        }
+        xSemaphoreGive(lock);
+        if (!name.empty()) {
+            sendDefinition(id, name, header.senderId);
+        }
+        return false;
+    }
+    return true;
+}
+
+void EventNames::sendDefinition(uint16_t id, const std::string& name, uint8_t receiverId) {
+    uint8_t data[2 + MAX_EVENT_NAME_SIZE];
+    data[0] = (uint8_t)(id >> 8);
+    data[1] = (uint8_t)(id & 0xFF);
+    memcpy(data + 2, name.data(), name.size());
+
+    EventHeader header{eventMsg.getAddr(), receiverId, 0x00, 0};
+    if (eventMsg.send(NAMES_DEF_EVENT, data, 2 + name.size(), header) == 0) return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    stats.definitionsSent++;
+    xSemaphoreGive(lock);
+}
+
+void EventNames::sendRequest(uint8_t senderId, uint16_t id) {
+    uint8_t data[] = {(uint8_t)(id >> 8), (uint8_t)(id & 0xFF)};
+    EventHeader header{eventMsg.getAddr(), senderId, 0x00, 0};
+    if (eventMsg.send(NAMES_REQ_EVENT, data, sizeof(data), header) == 0) return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    stats.requestsSent++;
+    xSemaphoreGive(lock);
+}
@@ -0,0 +1,327 @@
+#include "EventReliable.h"
+#include <string.h>
+
+ReliableChannel::ReliableChannel(EventMsg& eventMsg, uint8_t localAddr, uint8_t peerAddr, const Config& config)
+    : eventMsg(eventMsg), localAddr(localAddr), peerAddr(peerAddr), config(config) {
+    if (this->config.window == 0) this->config.window = 1;
+    if (this->config.window > RELIABLE_MAX_WINDOW) this->config.window = RELIABLE_MAX_WINDOW;
+    rto = 1000;
+    if (rto < this->config.minRto) rto = this->config.minRto;
+    if (rto > this->config.maxRto) rto = this->config.maxRto;
+}
+
+ReliableChannel::~ReliableChannel() {
+    end();
+}
+
+bool ReliableChannel::begin(const char* name) {
+    if (!filterName.empty()) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+            return this->onFrame(eventName, data, length, header);
+        });
+    if (!registered) return false;
+    filterName = name;
+
+    // Start a fresh sequence space and tell the peer where it begins
+    sndUna = sndNxt = (uint16_t)micros();
+    txSynced = false;
+    sendSync();
+    return true;
+}
+
+void ReliableChannel::end() {
+    if (!filterName.empty()) {
+        eventMsg.unregisterReceiveFilter(filterName.c_str());
+        filterName.clear();
+    }
+}
+
+size_t ReliableChannel::send(const char* name, const char* data, const EventHeader& header) {
+    return send(name, (const uint8_t*)data, strlen(data), header);
+}
+
+size_t ReliableChannel::send(const char* name, const uint8_t* data, size_t length, const EventHeader& header) {
+    if (!canSend()) return 0;
+
+    EventHeader reliableHeader = header;
+    reliableHeader.flags |= EVENT_FLAG_RELIABLE;
+
+    uint16_t seq = sndNxt;
+    TxSlot& slot = txSlots[seq % RELIABLE_MAX_WINDOW];
+    size_t frameLen = eventMsg.encodeFrame(name, data, length, reliableHeader, seq, slot.frame);
+    if (frameLen == 0) return 0;
+
+    slot.used = true;
+    slot.acked = false;
+    slot.retransmitted = false;
+    slot.backoff = 0;
+    slot.seq = seq;
+    sndNxt++;
+    stats.sent++;
+
+    transmit(slot, millis());
+    return frameLen;
+}
+
+void ReliableChannel::update() {
+    uint32_t now = millis();
+
+    if (!txSynced) {
+        if (now - syncSentAt >= rto) {
+            sendSync();
+        }
+    } else {
+        for (uint16_t seq = sndUna; seq != sndNxt; seq++) {
+            TxSlot& slot = txSlots[seq % RELIABLE_MAX_WINDOW];
+            if (!slot.used || slot.acked) continue;
+
+            uint32_t timeout = rto << slot.backoff;
+            if (timeout > config.maxRto) timeout = config.maxRto;
+            if (now - slot.sentAt >= timeout) {
+                slot.retransmitted = true;
+                if (slot.backoff < 6) slot.backoff++;
+                stats.retransmits++;
+                transmit(slot, now);
+            }
+        }
+    }
+
+    if (ackPending && now - ackPendingSince >= config.ackDelay) {
+        sendAck();
+    }
+}
+
+void ReliableChannel::transmit(TxSlot& slot, uint32_t now) {
+    slot.sentAt = now;
+    eventMsg.writeFrame(slot.frame.data(), slot.frame.size(), peerAddr);
+}
+
+void ReliableChannel::sampleRtt(uint32_t rtt) {
+    // RFC 6298 with srtt kept as ms*8 and rttvar as ms*4
+    if (!rttValid) {
+        srtt8 = rtt * 8;
+        rttvar4 = rtt * 2;
+        rttValid = true;
+    } else {
+        int32_t err = (int32_t)rtt - (int32_t)(srtt8 / 8);
+        srtt8 += err;
+        rttvar4 += (uint32_t)(err < 0 ? -err : err) - rttvar4 / 4;
+    }
+
+    rto = srtt8 / 8 + (rttvar4 > 1 ? rttvar4 : 1);
+    if (rto < config.minRto) rto = config.minRto;
+    if (rto > config.maxRto) rto = config.maxRto;
+}
+
+void ReliableChannel::sendControl(const char* name, const uint8_t* data, size_t length) {
+    EventHeader header{localAddr, peerAddr, 0x00, 0x00};
+    eventMsg.send(name, data, length, header);
+}
+
+void ReliableChannel::sendSync() {
+    uint8_t payload[2] = {(uint8_t)(sndUna >> 8), (uint8_t)(sndUna & 0xFF)};
+    syncSentAt = millis();
+    sendControl(RELIABLE_SYNC_EVENT, payload, sizeof(payload));
+}
+
+void ReliableChannel::sendAck() {
+    // Bit i acknowledges rcvNxt + 1 + i
+    uint32_t bitmap = 0;
+    for (uint8_t i = 0; i < RELIABLE_MAX_WINDOW; i++) {
+        uint16_t seq = rcvNxt + 1 + i;
+        if ((uint16_t)(seq - rcvNxt) >= config.window) break;
+        const RxSlot& slot = rxSlots[seq % RELIABLE_MAX_WINDOW];
+        if (slot.used && slot.seq == seq) {
+            bitmap |= (1UL << i);
+        }
+    }
+
+    uint8_t payload[6] = {
+        (uint8_t)(rcvNxt >> 8),
+        (uint8_t)(rcvNxt & 0xFF),
+        (uint8_t)(bitmap >> 24),
+        (uint8_t)(bitmap >> 16),
+        (uint8_t)(bitmap >> 8),
+        (uint8_t)(bitmap & 0xFF)
+    };
+    ackPending = false;
+    stats.acksSent++;
+    sendControl(RELIABLE_ACK_EVENT, payload, sizeof(payload));
+}
+
+bool ReliableChannel::onFrame(const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+    if (header.senderId != peerAddr) return true;
+    if (header.receiverId != localAddr && header.receiverId != BROADCAST_ADDR) return true;
+
+    if (header.flags & EVENT_FLAG_RELIABLE) {
+        onData(eventName, data, length, header);
+        return false;
+    }
+    if (eventName[0] != '_') return true;
+
+    if (strcmp(eventName, RELIABLE_ACK_EVENT) == 0) {
+        onAck(data, length);
+    } else if (strcmp(eventName, RELIABLE_NACK_EVENT) == 0) {
+        onNack(data, length);
+    } else if (strcmp(eventName, RELIABLE_SYNC_EVENT) == 0) {
+        onSync(data, length);
+    } else if (strcmp(eventName, RELIABLE_SYNCREQ_EVENT) == 0) {
+        // Peer lost its receive window; restart from the oldest unacked frame
+        txSynced = false;
+        sendSync();
+    } else {
+        return true;
+    }
+    return false;
+}
+
+void ReliableChannel::onData(const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+    if (!rxSynced) {
+        sendControl(RELIABLE_SYNCREQ_EVENT, nullptr, 0);
+        return;
+    }
+
+    uint16_t seq = header.msgId;
+    if (seqBefore(seq, rcvNxt)) {
+        // Already delivered; our ACK was probably lost
+        stats.duplicates++;
+        sendAck();
+        return;
+    }
+    if ((uint16_t)(seq - rcvNxt) >= config.window) {
+        sendAck();
+        return;
+    }
+
+    if (seq != rcvNxt) {
+        // Out of order: park it in its window slot and report the gap
+        RxSlot& slot = rxSlots[seq % RELIABLE_MAX_WINDOW];
+        if (slot.used && slot.seq == seq) {
+            stats.duplicates++;
+        } else {
+            slot.used = true;
+            slot.seq = seq;
+            slot.header = header;
+            slot.name = eventName;
+            slot.data.assign(data, data + length);
+            slot.data.push_back('\0');
+            stats.outOfOrder++;
+        }
+        sendAck();
+        if (!nackValid || lastNack != rcvNxt) {
+            uint8_t payload[2] = {(uint8_t)(rcvNxt >> 8), (uint8_t)(rcvNxt & 0xFF)};
+            lastNack = rcvNxt;
+            nackValid = true;
+            stats.nacksSent++;
+            sendControl(RELIABLE_NACK_EVENT, payload, sizeof(payload));
+        }
+        return;
+    }
+
+    eventMsg.deliver(eventName, data, length, header);
+    stats.delivered++;
+    rcvNxt++;
+
+    // Drain frames that were waiting on this one
+    bool drained = false;
+    while (true) {
+        RxSlot& slot = rxSlots[rcvNxt % RELIABLE_MAX_WINDOW];
+        if (!slot.used || slot.seq != rcvNxt) break;
+        eventMsg.deliver(slot.name.c_str(), slot.data.data(), slot.data.size() - 1, slot.header);
+        slot.used = false;
+        stats.delivered++;
+        rcvNxt++;
+        drained = true;
+    }
+
+    if (drained || config.ackDelay == 0) {
+        sendAck();
+    } else if (!ackPending) {
+        ackPending = true;
+        ackPendingSince = millis();
+    }
+}
+
+void ReliableChannel::onAck(const uint8_t* data, size_t length) {
+    if (length < 6) return;
+    uint16_t cumAck = (uint16_t)((data[0] << 8) | data[1]);
+    uint32_t bitmap = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) |
+                      ((uint32_t)data[4] << 8) | (uint32_t)data[5];
+    uint32_t now = millis();
+    stats.acksReceived++;
+
+    if (!txSynced) {
+        // First ACK at our sync point means the peer adopted it
+        if (cumAck != sndUna) return;
+        txSynced = true;
+        for (uint16_t seq = sndUna; seq != sndNxt; seq++) {
+            TxSlot& slot = txSlots[seq % RELIABLE_MAX_WINDOW];
+            if (slot.used) {
+                slot.acked = false;
+                transmit(slot, now);
+            }
+        }
+        return;
+    }
+
+    // Ignore ACKs that claim frames we have not sent
+    if (seqBefore(sndNxt, cumAck)) return;
+
+    while (seqBefore(sndUna, cumAck)) {
+        TxSlot& slot = txSlots[sndUna % RELIABLE_MAX_WINDOW];
+        if (slot.used && !slot.acked && !slot.retransmitted) {
+            sampleRtt(now - slot.sentAt);
+        }
+        slot.used = false;
+        slot.frame.clear();
+        sndUna++;
+    }
+
+    for (uint8_t i = 0; i < RELIABLE_MAX_WINDOW; i++) {
+        if (!(bitmap & (1UL << i))) continue;
+        uint16_t seq = cumAck + 1 + i;
+        if (!seqBefore(seq, sndNxt)) break;
+        TxSlot& slot = txSlots[seq % RELIABLE_MAX_WINDOW];
+        if (slot.used && slot.seq == seq && !slot.acked) {
+            if (!slot.retransmitted) {
+                sampleRtt(now - slot.sentAt);
+            }
+            slot.acked = true;
+        }
+    }
+}
+
+void ReliableChannel::onNack(const uint8_t* data, size_t length) {
+    if (length < 2 || !txSynced) return;
+    uint16_t seq = (uint16_t)((data[0] << 8) | data[1]);
+    stats.nacksReceived++;
+
+    if (seqBefore(seq, sndUna) || !seqBefore(seq, sndNxt)) return;
+    TxSlot& slot = txSlots[seq % RELIABLE_MAX_WINDOW];
+    if (!slot.used || slot.acked || slot.seq != seq) return;
+
+    // Skip if a copy went out recently enough to still be in flight
+    uint32_t now = millis();
+    if (slot.retransmitted && now - slot.sentAt < getSrtt()) return;
+    slot.retransmitted = true;
+    stats.retransmits++;
+    transmit(slot, now);
+}
+
+void ReliableChannel::onSync(const uint8_t* data, size_t length) {
+    if (length < 2) return;
+    uint16_t seq = (uint16_t)((data[0] << 8) | data[1]);
+
+    if (!rxSynced || seq != rcvNxt) {
+        for (auto& slot : rxSlots) {
+            slot.used = false;
+            slot.data.clear();
+        }
+        rcvNxt = seq;
+        rxSynced = true;
+        nackValid = false;
+    }
+    sendAck();
+}
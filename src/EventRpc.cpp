@@ -0,0 +1,133 @@
+#include "EventRpc.h"
+#include <string.h>
+
+RpcClient::RpcClient(EventMsg& eventMsg, size_t maxPending)
+    : eventMsg(eventMsg), calls(maxPending > 0 ? maxPending : 1) {
+}
+
+RpcClient::~RpcClient() {
+    end();
+}
+
+bool RpcClient::begin(const char* name) {
+    if (!filterName.empty()) return false;
+
+    bool registered = eventMsg.registerReceiveFilter(name,
+        [this](EventSourceId, const char* eventName, const uint8_t* data, size_t length, EventHeader& header) {
+            return this->onFrame(eventName, data, length, header);
+        });
+    if (!registered) return false;
+    filterName = name;
+    return true;
+}
+
+void RpcClient::end() {
+    if (!filterName.empty()) {
+        eventMsg.unregisterReceiveFilter(filterName.c_str());
+        filterName.clear();
+    }
+
+    EventHeader empty{};
+    for (auto& call : calls) {
+        if (call.used) {
+            complete(call, RpcStatus::CANCELLED, "", 0, empty);
+        }
+    }
+}
+
+int32_t RpcClient::call(const char* event, const char* payload, const EventHeader& header,
+                        uint32_t timeoutMs, RpcCallback cb) {
+    return call(event, (const uint8_t*)payload, strlen(payload), header, timeoutMs, cb);
+}
+
+int32_t RpcClient::call(const char* event, const uint8_t* payload, size_t length, const EventHeader& header,
+                        uint32_t timeoutMs, RpcCallback cb) {
+    stats.calls++;
+
+    PendingCall* slot = nullptr;
+    for (auto& call : calls) {
+        if (!call.used) {
+            slot = &call;
+            break;
+        }
+    }
+    if (slot == nullptr) {
+        stats.rejected++;
+        return -1;
+    }
+
+    EventHeader requestHeader = header;
+    requestHeader.flags &= ~EVENT_FLAG_RESPONSE;
+    uint16_t msgId = eventMsg.nextMsgId();
+
+    // Park the call before writing: a loopback transport may answer inline
+    slot->used = true;
+    slot->msgId = msgId;
+    slot->peer = header.receiverId;
+    slot->deadline = millis() + timeoutMs;
+    slot->callback = cb;
+    pendingCount++;
+
+    PSRAMVector<uint8_t> frame;
+    size_t frameLen = eventMsg.encodeFrame(event, payload, length, requestHeader, msgId, frame);
+    if (frameLen == 0 || !eventMsg.writeFrame(frame.data(), frameLen, requestHeader.receiverId)) {
+        if (slot->used && slot->msgId == msgId) {
+            slot->used = false;
+            slot->callback = nullptr;
+            pendingCount--;
+        }
+        stats.rejected++;
+        return -1;
+    }
+    return msgId;
+}
+
+bool RpcClient::cancel(uint16_t msgId) {
+    for (auto& call : calls) {
+        if (call.used && call.msgId == msgId) {
+            EventHeader empty{};
+            complete(call, RpcStatus::CANCELLED, "", 0, empty);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RpcClient::update() {
+    uint32_t now = millis();
+    EventHeader empty{};
+    for (auto& call : calls) {
+        if (call.used && (int32_t)(now - call.deadline) >= 0) {
+            stats.timeouts++;
+            complete(call, RpcStatus::TIMEOUT, "", 0, empty);
+        }
+    }
+}
+
+bool RpcClient::onFrame(const char*, const uint8_t* data, size_t length, EventHeader& header) {
+    if (!(header.flags & EVENT_FLAG_RESPONSE) || pendingCount == 0) return true;
+
+    for (auto& call : calls) {
+        if (call.used && call.msgId == header.msgId &&
+            (call.peer == header.senderId || call.peer == BROADCAST_ADDR)) {
+            stats.completed++;
+            complete(call, RpcStatus::OK, (const char*)data, length, header);
+            return false;
+        }
+    }
+
+    // Not ours (late, cancelled or someone else's request): dispatch normally
+    return true;
+}
+
+void RpcClient::complete(PendingCall& call, RpcStatus status, const char* data, size_t length, EventHeader& header) {
+    // Free the slot first so the callback can issue a follow-up call
+    RpcCallback callback = call.callback;
+    call.used = false;
+    call.callback = nullptr;
+    pendingCount--;
+
+    if (callback) {
+        callback(status, data, length, header);
+    }
+}
@@ -0,0 +1,499 @@
+#include "EventTcp.h"
+
+#if EVENT_TCP_AVAILABLE
+
+#include <string.h>
+
+#if EVENT_TCP_HOST
+
+#include <errno.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+static void setNoDelay(int fd) {
+    // Frames are small; don't let Nagle hold them back
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+TcpServer::TcpServer(FdTransport& fds, uint16_t port, size_t maxClients)
+    : fds(fds), clients(maxClients), port(port) {
+}
+
+TcpServer::~TcpServer() {
+    end();
+}
+
+bool TcpServer::begin() {
+    if (listenFd >= 0) return true;
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    socklen_t addrLen = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0 ||
+        getsockname(listenFd, (sockaddr*)&addr, &addrLen) < 0 ||
+        !fds.addListener(listenFd, [this](int fd) { this->accept(fd); })) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    port = ntohs(addr.sin_port);
+    return true;
+}
+
+void TcpServer::end() {
+    if (listenFd < 0) return;
+    fds.removeListener(listenFd);
+    ::close(listenFd);
+    listenFd = -1;
+
+    // Release the slots first, so a close the reactor is handling right now
+    // finds nothing to do, then remove the fds without the lock: removeFd()
+    // waits for the reactor, which may be waiting for the lock in closed()
+    std::vector<EventSourceId> open;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        clients.forEach([&](uint16_t index, Client& client) {
+            open.push_back(client.sourceId);
+            clients.free(index);
+        });
+    }
+    for (EventSourceId sourceId : open) {
+        fds.removeFd(sourceId);
+    }
+}
+
+bool TcpServer::disconnect(EventSourceId sourceId) {
+    return fds.shutdownFd(sourceId);
+}
+
+size_t TcpServer::clientCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return clients.size();
+}
+
+void TcpServer::accept(int fd) {
+    EventSourceId sourceId = 0;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        uint16_t index = clients.alloc();
+        if (index != EventSlab<Client>::NONE) {
+            setNoDelay(fd);
+            sourceId = fds.addFd(fd, true, [this, index](EventSourceId id, int) {
+                this->closed(index, id);
+            });
+            if (sourceId == 0) {
+                clients.free(index);
+            } else {
+                clients[index].sourceId = sourceId;
+                clients[index].connectedAt = millis();
+            }
+        }
+        if (sourceId == 0) {
+            ::close(fd);
+            stats.rejected++;
+            return;
+        }
+        stats.accepted++;
+    }
+
+    if (connectCallback) {
+        connectCallback(sourceId);
+    }
+}
+
+void TcpServer::closed(uint16_t index, EventSourceId sourceId) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        // end() may have released the slot already
+        if (!clients.isUsed(index) || clients[index].sourceId != sourceId) return;
+        clients.free(index);
+        stats.disconnected++;
+    }
+
+    fds.removeFd(sourceId);
+    if (disconnectCallback) {
+        disconnectCallback(sourceId);
+    }
+}
+
+TcpClient::TcpClient(FdTransport& fds) : fds(fds) {
+}
+
+TcpClient::~TcpClient() {
+    // Also waits out a close callback the reactor may be running for us
+    if (connected) {
+        fds.removeFd(sourceId);
+    }
+}
+
+bool TcpClient::connect(const char* host, uint16_t port) {
+    if (connected) return false;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, service, &hints, &result) != 0) return false;
+
+    int fd = -1;
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0) return false;
+
+    setNoDelay(fd);
+    // Set before addFd: the reactor may see the peer hang up right away
+    connected = true;
+    sourceId = fds.addFd(fd, true, [this](EventSourceId id, int) {
+        fds.removeFd(id);
+        if (disconnectCallback) {
+            disconnectCallback(id);
+        }
+        // Last: once this reads false the client may be destroyed
+        connected = false;
+    });
+    if (sourceId == 0) {
+        connected = false;
+        ::close(fd);
+        return false;
+    }
+
+    if (connectCallback) {
+        connectCallback(sourceId);
+    }
+    return true;
+}
+
+void TcpClient::disconnect() {
+    if (connected) {
+        fds.shutdownFd(sourceId);
+    }
+}
+
+#else // EVENT_TCP_ASYNC
+
+// Callers hold the connection's lock
+
+static void tcpFlush(TcpConnection& conn) {
+    if (conn.client == nullptr || conn.txLen == 0) return;
+    size_t n = conn.client->space();
+    if (n > conn.txLen) n = conn.txLen;
+    if (n == 0) return;
+
+    conn.client->add((const char*)conn.tx.data(), n);
+    conn.client->send();
+    memmove(conn.tx.data(), conn.tx.data() + n, conn.txLen - n);
+    conn.txLen -= n;
+}
+
+static bool tcpWrite(TcpConnection& conn, const uint8_t* data, size_t len) {
+    if (conn.client == nullptr || !conn.client->connected()) return false;
+
+    if (conn.txLen == 0 && conn.client->space() >= len) {
+        conn.client->add((const char*)data, len);
+        return conn.client->send();
+    }
+
+    // Queue whole frames only, behind whatever is already waiting
+    if (conn.txLen + len > conn.tx.size()) return false;
+    memcpy(conn.tx.data() + conn.txLen, data, len);
+    conn.txLen += len;
+    tcpFlush(conn);
+    return true;
+}
+
+// AsyncTCP calls back on its own task: hand the bytes to the source queue
+// in packet-sized pieces for processAllSources() to parse
+static void tcpReceive(SourceQueueManager& sources, EventSourceId sourceId, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t chunk = len < RawPacket::MAX_SIZE ? len : RawPacket::MAX_SIZE;
+        if (!sources.pushToSource(sourceId, data, chunk)) {
+            DEBUG_PRINT("TCP source %d queue full, dropped %d bytes", sourceId, len);
+            return;
+        }
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+TcpServer::TcpServer(EventMsg& eventMsg, uint16_t port, size_t maxClients, size_t txBufferSize)
+    : eventMsg(eventMsg), clients(maxClients), txBufferSize(txBufferSize), port(port) {
+}
+
+TcpServer::~TcpServer() {
+    end();
+    for (uint16_t i = 0; i < clients.capacity(); i++) {
+        if (clients[i].sourceId != 0) {
+            eventMsg.removeSource(clients[i].sourceId);
+        }
+    }
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool TcpServer::begin() {
+    if (server != nullptr) return true;
+    if (lock == nullptr) {
+        lock = xSemaphoreCreateMutex();
+        if (lock == nullptr) return false;
+    }
+
+    // Every slot gets its source and transmit buffer now, so a connect
+    // never allocates and never changes the source tables
+    for (uint16_t i = 0; i < clients.capacity(); i++) {
+        TcpConnection& conn = clients[i];
+        if (conn.sourceId != 0) continue;
+
+        conn.sourceId = eventMsg.createSource(RawPacket::MAX_SIZE, 8);
+        if (conn.sourceId == 0) return false;
+        conn.tx.resize(txBufferSize);
+        eventMsg.setSourceTransport(conn.sourceId, [this, i](uint8_t* data, size_t len) {
+            xSemaphoreTake(lock, portMAX_DELAY);
+            bool ok = clients.isUsed(i) && tcpWrite(clients[i], data, len);
+            xSemaphoreGive(lock);
+            return ok;
+        });
+    }
+
+    server = new AsyncServer(port);
+    server->onClient(&TcpServer::handleClient, this);
+    server->begin();
+    return true;
+}
+
+void TcpServer::end() {
+    if (server == nullptr) return;
+    server->end();
+    delete server;
+    server = nullptr;
+
+    // close() runs the disconnect callback, which takes the lock and
+    // releases the slot, so collect the clients first and close them
+    // with the lock released
+    PSRAMVector<AsyncClient*> open;
+    open.reserve(clients.capacity());
+    xSemaphoreTake(lock, portMAX_DELAY);
+    clients.forEach([&](uint16_t, TcpConnection& conn) {
+        if (conn.client != nullptr) open.push_back(conn.client);
+    });
+    xSemaphoreGive(lock);
+
+    for (AsyncClient* client : open) {
+        client->close(true);
+    }
+}
+
+bool TcpServer::disconnect(EventSourceId sourceId) {
+    AsyncClient* client = nullptr;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    clients.forEach([&](uint16_t, TcpConnection& conn) {
+        if (conn.sourceId == sourceId && conn.client != nullptr) {
+            client = conn.client;
+        }
+    });
+    xSemaphoreGive(lock);
+
+    // Not under the lock: close() runs the disconnect callback, which takes it
+    if (client == nullptr) return false;
+    client->close();
+    return true;
+}
+
+size_t TcpServer::clientCount() const {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t count = clients.size();
+    xSemaphoreGive(lock);
+    return count;
+}
+
+void TcpServer::handleClient(void* arg, AsyncClient* client) {
+    static_cast<TcpServer*>(arg)->accept(client);
+}
+
+void TcpServer::accept(AsyncClient* client) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint16_t index = clients.alloc();
+    if (index == EventSlab<TcpConnection>::NONE) {
+        stats.rejected++;
+        xSemaphoreGive(lock);
+        client->onDisconnect([](void*, AsyncClient* c) { delete c; }, nullptr);
+        client->close(true);
+        return;
+    }
+
+    TcpConnection& conn = clients[index];
+    conn.client = client;
+    conn.txLen = 0;
+    conn.connectedAt = millis();
+    EventSourceId sourceId = conn.sourceId;
+    stats.accepted++;
+    xSemaphoreGive(lock);
+
+    client->setNoDelay(true);
+    SourceQueueManager* sources = &eventMsg.getSourceManager();
+    client->onData([sources, sourceId](void*, AsyncClient*, void* data, size_t len) {
+        tcpReceive(*sources, sourceId, (const uint8_t*)data, len);
+    }, nullptr);
+    auto flush = [this, index](void*, AsyncClient*) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (clients.isUsed(index)) tcpFlush(clients[index]);
+        xSemaphoreGive(lock);
+    };
+    client->onAck([flush](void* arg, AsyncClient* c, size_t, uint32_t) { flush(arg, c); }, nullptr);
+    client->onPoll(flush, nullptr);
+    client->onDisconnect([this, index](void*, AsyncClient* c) {
+        this->closed(index);
+        delete c;
+    }, nullptr);
+
+    if (connectCallback) {
+        connectCallback(sourceId);
+    }
+}
+
+void TcpServer::closed(uint16_t index) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    TcpConnection& conn = clients[index];
+    EventSourceId sourceId = conn.sourceId;
+    conn.client = nullptr;
+    conn.txLen = 0;
+    clients.free(index);
+    stats.disconnected++;
+    xSemaphoreGive(lock);
+
+    // The source is reused by the next client in this slot
+    eventMsg.forgetRoutesVia(sourceId);
+    if (disconnectCallback) {
+        disconnectCallback(sourceId);
+    }
+}
+
+TcpClient::TcpClient(EventMsg& eventMsg, size_t txBufferSize) : eventMsg(eventMsg) {
+    conn.tx.resize(txBufferSize);
+}
+
+TcpClient::~TcpClient() {
+    if (lock != nullptr) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (conn.client != nullptr) {
+            // Callbacks must not reach this object once it is gone
+            conn.client->onDisconnect([](void*, AsyncClient* c) { delete c; }, nullptr);
+            conn.client->close(true);
+            conn.client = nullptr;
+        }
+        xSemaphoreGive(lock);
+    }
+    if (sourceId != 0) {
+        eventMsg.removeSource(sourceId);
+    }
+    if (lock != nullptr) {
+        vSemaphoreDelete(lock);
+    }
+}
+
+bool TcpClient::connect(const char* host, uint16_t port) {
+    if (lock == nullptr) {
+        lock = xSemaphoreCreateMutex();
+        if (lock == nullptr) return false;
+    }
+    if (conn.client != nullptr) return false;
+
+    if (sourceId == 0) {
+        sourceId = eventMsg.createSource(RawPacket::MAX_SIZE, 8);
+        if (sourceId == 0) return false;
+        conn.sourceId = sourceId;
+        eventMsg.setSourceTransport(sourceId, [this](uint8_t* data, size_t len) {
+            xSemaphoreTake(lock, portMAX_DELAY);
+            bool ok = connected && tcpWrite(conn, data, len);
+            xSemaphoreGive(lock);
+            return ok;
+        });
+    }
+
+    AsyncClient* client = new AsyncClient();
+    client->onConnect([this](void*, AsyncClient* c) {
+        c->setNoDelay(true);
+        connected = true;
+        if (connectCallback) {
+            connectCallback(sourceId);
+        }
+    }, nullptr);
+    client->onData([this](void*, AsyncClient*, void* data, size_t len) {
+        tcpReceive(eventMsg.getSourceManager(), sourceId, (const uint8_t*)data, len);
+    }, nullptr);
+    auto flush = [this](void*, AsyncClient*) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        tcpFlush(conn);
+        xSemaphoreGive(lock);
+    };
+    client->onAck([flush](void* arg, AsyncClient* c, size_t, uint32_t) { flush(arg, c); }, nullptr);
+    client->onPoll(flush, nullptr);
+    // Also runs when the connect attempt fails
+    client->onDisconnect([this](void*, AsyncClient* c) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        bool wasConnected = connected;
+        connected = false;
+        conn.client = nullptr;
+        conn.txLen = 0;
+        xSemaphoreGive(lock);
+
+        eventMsg.forgetRoutesVia(sourceId);
+        delete c;
+        if (wasConnected && disconnectCallback) {
+            disconnectCallback(sourceId);
+        }
+    }, nullptr);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    conn.client = client;
+    conn.txLen = 0;
+    xSemaphoreGive(lock);
+
+    if (!client->connect(host, port)) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        conn.client = nullptr;
+        xSemaphoreGive(lock);
+        delete client;
+        return false;
+    }
+    return true;
+}
+
+void TcpClient::disconnect() {
+    if (lock == nullptr) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    AsyncClient* client = conn.client;
+    xSemaphoreGive(lock);
+
+    // Not under the lock: close() runs the disconnect callback, which takes it
+    if (client != nullptr) {
+        client->close();
+    }
+}
+
+#endif // EVENT_TCP_HOST
+
+#endif // EVENT_TCP_AVAILABLE
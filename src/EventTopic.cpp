@@ -0,0 +1,82 @@
+#include "EventTopic.h"
+
+uint32_t TopicTrie::findChild(const Node& node, const char* token, size_t length) const {
+    size_t low = 0;
+    size_t high = node.children.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int order = node.children[mid].token.compare(0, std::string::npos, token, length);
+        if (order == 0) return node.children[mid].node;
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return NONE;
+}
+
+uint32_t TopicTrie::walk(const char* pattern, bool create) {
+    uint32_t index = 0;
+    const char* level = pattern;
+    while (true) {
+        const char* end = strchr(level, '/');
+        bool last = (end == nullptr);
+        size_t length = last ? strlen(level) : (size_t)(end - level);
+
+        uint32_t next;
+        if (length == 1 && level[0] == '*') {
+            next = nodes[index].any;
+            if (next == NONE && create) {
+                next = (uint32_t)nodes.size();
+                nodes[index].any = next;
+                nodes.emplace_back();
+            }
+        } else if (length == 1 && level[0] == '#' && last) {
+            next = nodes[index].rest;
+            if (next == NONE && create) {
+                next = (uint32_t)nodes.size();
+                nodes[index].rest = next;
+                nodes.emplace_back();
+            }
+        } else {
+            next = findChild(nodes[index], level, length);
+            if (next == NONE && create) {
+                next = (uint32_t)nodes.size();
+                // Keep children sorted for findChild's binary search
+                PSRAMVector<Edge>& children = nodes[index].children;
+                auto it = children.begin();
+                while (it != children.end() && it->token.compare(0, std::string::npos, level, length) < 0) ++it;
+                children.insert(it, Edge{std::string(level, length), next});
+                nodes.emplace_back();
+            }
+        }
+        if (next == NONE) return NONE;
+        index = next;
+        if (last) return index;
+        level = end + 1;
+    }
+}
+
+void TopicTrie::insert(const char* pattern, uint16_t id) {
+    uint32_t index = walk(pattern, true);
+    for (uint16_t existing : nodes[index].ids) {
+        if (existing == id) return;
+    }
+    nodes[index].ids.push_back(id);
+    patterns++;
+}
+
+bool TopicTrie::remove(const char* pattern, uint16_t id) {
+    uint32_t index = walk(pattern, false);
+    if (index == NONE) return false;
+    PSRAMVector<uint16_t>& ids = nodes[index].ids;
+    for (auto it = ids.begin(); it != ids.end(); ++it) {
+        if (*it == id) {
+            ids.erase(it);
+            patterns--;
+            return true;
+        }
+    }
+    return false;
+}
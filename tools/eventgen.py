@@ -0,0 +1,407 @@
+#!/usr/bin/env python3
+"""Generate a C++ header with static dispatch for an event catalog.
+
+    python3 tools/eventgen.py catalog.json -o include/GreenhouseEvents.h
+
+The catalog is JSON:
+
+    {
+      "catalog": "greenhouse",
+      "events": [
+        {"name": "telemetry", "fields": [
+          {"name": "temperature", "type": "f32"},
+          {"name": "batteryMv", "type": "u16"},
+          {"name": "serial", "type": "char", "count": 12}
+        ]},
+        {"name": "log", "payload": "text"},
+        {"name": "reboot"}
+      ]
+    }
+
+An event with "fields" gets an EVENT_PACKED struct (see EventTyped.h). One
+with "payload": "text" or "bytes" passes its data through. One with neither
+has no payload. "id" is optional; events without one are numbered after
+the highest given id.
+
+The header declares, in a namespace named after the catalog:
+  - an EventId enum with the ids, and eventName()/eventId() to map both ways
+  - the payload structs
+  - Handlers, a base with an empty on<Event>() per event, and
+    dispatch()/registerWith() templates calling the derived class directly
+  - Sender, with a prepared send helper per event
+"""
+
+import argparse
+import json
+import re
+import sys
+
+TYPES = {
+    "bool": ("bool", 1),
+    "u8": ("uint8_t", 1),
+    "i8": ("int8_t", 1),
+    "u16": ("uint16_t", 2),
+    "i16": ("int16_t", 2),
+    "u32": ("uint32_t", 4),
+    "i32": ("int32_t", 4),
+    "u64": ("uint64_t", 8),
+    "i64": ("int64_t", 8),
+    "f32": ("float", 4),
+    "f64": ("double", 8),
+    "char": ("char", 1),
+}
+
+PAYLOADS = ("struct", "text", "bytes", "none")
+
+MAX_EVENT_DATA_SIZE = 2048  # EventMsg.h
+MAX_NAME_SIZE = 32         # MAX_EVENT_NAME_SIZE
+MAX_ID = 0xFFFF
+
+CPP_KEYWORDS = {
+    "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char",
+    "class", "const", "constexpr", "continue", "default", "delete", "do", "double", "else",
+    "enum", "explicit", "extern", "false", "float", "for", "friend", "goto", "if", "inline",
+    "int", "long", "mutable", "namespace", "new", "noexcept", "not", "nullptr", "operator",
+    "or", "private", "protected", "public", "register", "return", "short", "signed",
+    "sizeof", "static", "struct", "switch", "template", "this", "throw", "true", "try",
+    "typedef", "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "while", "xor",
+}
+
+
+class CatalogError(Exception):
+    pass
+
+
+def words(name):
+    """Split an event or field name into words at separators and case changes."""
+    parts = re.split(r"[^A-Za-z0-9]+", name)
+    result = []
+    for part in parts:
+        result.extend(w for w in re.findall(r"[A-Z]+(?![a-z])|[A-Z]?[a-z0-9]+|[0-9]+", part) if w)
+    return result
+
+
+def pascal(name):
+    return "".join(w[:1].upper() + w[1:] for w in words(name))
+
+
+def camel(name):
+    p = pascal(name)
+    return p[:1].lower() + p[1:]
+
+
+def upper(name):
+    return "_".join(w.upper() for w in words(name))
+
+
+def check_identifier(ident, what):
+    if not ident or not re.match(r"^[A-Za-z_][A-Za-z0-9_]*$", ident) or ident in CPP_KEYWORDS:
+        raise CatalogError("%s does not make a C++ identifier (got %r)" % (what, ident))
+    return ident
+
+
+def fnv1a(name, basis):
+    h = basis
+    for b in name.encode("utf-8"):
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def perfect_hash(names):
+    """Find (basis, size) so fnv1a(name, basis) % size differs for every name."""
+    n = max(len(names), 1)
+    for size in range(n, 4 * n + 1):
+        for attempt in range(256):
+            basis = fnv1a(str(attempt), 2166136261) if attempt else 2166136261
+            slots = set(fnv1a(name, basis) % size for name in names)
+            if len(slots) == len(names):
+                return basis, size
+    raise CatalogError("no perfect hash found for %d names" % len(names))
+
+
+def load(path):
+    with open(path, "r", encoding="utf-8") as f:
+        try:
+            doc = json.load(f)
+        except ValueError as e:
+            raise CatalogError("%s: %s" % (path, e))
+
+    catalog = doc.get("catalog")
+    if not isinstance(catalog, str):
+        raise CatalogError("missing \"catalog\" name")
+    namespace = check_identifier(re.sub(r"[^A-Za-z0-9_]", "_", catalog), "catalog name")
+
+    raw = doc.get("events")
+    if not isinstance(raw, list) or not raw:
+        raise CatalogError("\"events\" must be a non-empty list")
+
+    events = []
+    names = set()
+    ids = set()
+    for entry in raw:
+        name = entry.get("name")
+        if not isinstance(name, str) or not name:
+            raise CatalogError("every event needs a \"name\"")
+        # Names go into C++ string literals as they are
+        if not re.match(r"[ -~]+\Z", name) or "\"" in name or "\\" in name:
+            raise CatalogError("%r: names are printable ASCII without '\"' or '\\'" % name)
+        if len(name.encode("utf-8")) >= MAX_NAME_SIZE:
+            raise CatalogError("%s: name longer than %d bytes" % (name, MAX_NAME_SIZE - 1))
+        if any(c in name for c in "*#") or name.startswith("_"):
+            raise CatalogError("%s: wildcards and reserved '_' names are not catalog events" % name)
+        if name in names:
+            raise CatalogError("%s: listed twice" % name)
+        names.add(name)
+
+        fields = entry.get("fields")
+        payload = entry.get("payload", "struct" if fields else "none")
+        if payload not in PAYLOADS:
+            raise CatalogError("%s: payload must be one of %s" % (name, ", ".join(PAYLOADS)))
+        if (payload == "struct") != bool(fields):
+            raise CatalogError("%s: \"fields\" goes with a struct payload only" % name)
+
+        event = {
+            "name": name,
+            "id": entry.get("id"),
+            "payload": payload,
+            "description": entry.get("description", ""),
+            "enum": check_identifier(upper(name), "%s: name" % name),
+            "type": check_identifier(pascal(name), "%s: name" % name),
+            "method": check_identifier(camel(name), "%s: name" % name),
+            "fields": [],
+            "size": 0,
+        }
+        if event["id"] is not None:
+            if not isinstance(event["id"], int) or not 1 <= event["id"] <= MAX_ID:
+                raise CatalogError("%s: id must be 1-%d" % (name, MAX_ID))
+            if event["id"] in ids:
+                raise CatalogError("%s: id %d already used" % (name, event["id"]))
+            ids.add(event["id"])
+
+        seen = set()
+        for field in fields or []:
+            fname = check_identifier(field.get("name"), "%s: field name" % name)
+            if fname == "payload":
+                raise CatalogError("%s.payload: reserved for the send helpers" % name)
+            if fname in seen:
+                raise CatalogError("%s.%s: listed twice" % (name, fname))
+            seen.add(fname)
+            ftype = field.get("type")
+            if ftype not in TYPES:
+                raise CatalogError("%s.%s: type must be one of %s" % (name, fname, ", ".join(TYPES)))
+            count = field.get("count", 1)
+            if not isinstance(count, int) or count < 1:
+                raise CatalogError("%s.%s: count must be a positive integer" % (name, fname))
+            ctype, size = TYPES[ftype]
+            event["fields"].append({"name": fname, "ctype": ctype, "count": count,
+                                    "array": "count" in field, "doc": field.get("description", "")})
+            event["size"] += size * count
+        if event["size"] > MAX_EVENT_DATA_SIZE:
+            raise CatalogError("%s: %d bytes exceeds MAX_EVENT_DATA_SIZE" % (name, event["size"]))
+        events.append(event)
+
+    # Names the generated header already uses
+    reserved = {"enum": {"UNKNOWN_EVENT"}, "type": {"Unknown", "EventId", "Handlers", "Sender"},
+                "method": {"isValid"}}
+    for attr in ("enum", "type", "method"):
+        seen = dict((r, "the generated header") for r in reserved[attr])
+        for event in events:
+            other = seen.setdefault(event[attr], event["name"])
+            if other != event["name"]:
+                raise CatalogError("%s and %s both become %s" % (other, event["name"], event[attr]))
+
+    next_id = max(ids) + 1 if ids else 1
+    for event in events:
+        if event["id"] is None:
+            if next_id > MAX_ID:
+                raise CatalogError("ran out of ids")
+            event["id"] = next_id
+            ids.add(next_id)
+            next_id += 1
+
+    return catalog, namespace, events
+
+
+def handler_signature(event):
+    if event["payload"] == "struct":
+        return "const %s& payload, EventHeader& header" % event["type"]
+    if event["payload"] == "none":
+        return "EventHeader& header"
+    return "const char* data, size_t length, EventHeader& header"
+
+
+def generate(source, catalog, namespace, events):
+    guard = "%s_EVENTS_H" % namespace.upper()
+    basis, size = perfect_hash([e["name"] for e in events])
+    out = []
+    w = out.append
+
+    w("// Generated by tools/eventgen.py from %s. Do not edit." % source)
+    w("#ifndef %s" % guard)
+    w("#define %s" % guard)
+    w("")
+    w("#include \"EventMsg.h\"")
+    w("#include \"EventTyped.h\"")
+    w("#include <string.h>")
+    w("")
+    w("namespace %s {" % namespace)
+    w("")
+    w("enum EventId : uint16_t {")
+    w("    UNKNOWN_EVENT = 0,")
+    for e in events:
+        w("    %s = %d," % (e["enum"], e["id"]))
+    w("};")
+    w("")
+    w("static constexpr size_t EVENT_COUNT = %d;" % len(events))
+    w("")
+
+    for e in (e for e in events if e["payload"] == "struct"):
+        if e["description"]:
+            w("// %s" % e["description"])
+        w("struct EVENT_PACKED %s {" % e["type"])
+        decls = ["    %s %s%s;" % (f["ctype"], f["name"], "[%d]" % f["count"] if f["array"] else "")
+                 for f in e["fields"]]
+        width = max(len(d) for d in decls)
+        for decl, f in zip(decls, e["fields"]):
+            w(decl.ljust(width) + "  // %s" % f["doc"] if f["doc"] else decl)
+        w("};")
+        w("static_assert(sizeof(%s) == %d, \"%s: layout does not match the catalog\");"
+          % (e["type"], e["size"], e["name"]))
+        w("")
+
+    w("inline const char* eventName(uint16_t id) {")
+    w("    switch (id) {")
+    for e in events:
+        w("    case %s: return \"%s\";" % (e["enum"], e["name"]))
+    w("    default: return nullptr;")
+    w("    }")
+    w("}")
+    w("")
+    w("// FNV-1a with a basis picked so every catalog name lands in its own slot")
+    w("inline EventId eventId(const char* name) {")
+    w("    uint32_t hash = 0x%08Xu;" % basis)
+    w("    for (const char* p = name; *p; p++) {")
+    w("        hash = (hash ^ (uint8_t)*p) * 16777619u;")
+    w("    }")
+    w("    EventId id;")
+    w("    switch (hash %% %du) {" % size)
+    for e in sorted(events, key=lambda e: fnv1a(e["name"], basis) % size):
+        w("    case %d: id = %s; break;" % (fnv1a(e["name"], basis) % size, e["enum"]))
+    w("    default: return UNKNOWN_EVENT;")
+    w("    }")
+    w("    return strcmp(name, eventName(id)) == 0 ? id : UNKNOWN_EVENT;")
+    w("}")
+    w("")
+    w("// Derive from Handlers and define the on<Event>() methods you need;")
+    w("// dispatch() calls them on the derived type, with no table or lookup")
+    w("// at runtime beyond eventId().")
+    w("struct Handlers {")
+    for e in events:
+        params = handler_signature(e)
+        unnamed = re.sub(r" (payload|data|length|header)(?=,|$)", "", params)
+        w("    void on%s(%s) {}" % (e["type"], unnamed))
+    w("    void onUnknown(const char*, const char*, size_t, EventHeader&) {}")
+    w("};")
+    w("")
+    w("// Returns false for names outside the catalog and payloads too short")
+    w("// for their struct")
+    w("template <typename H>")
+    w("bool dispatch(H& handler, const char* eventName, const char* data, size_t length, EventHeader& header) {")
+    w("    switch (eventId(eventName)) {")
+    for e in events:
+        w("    case %s: {" % e["enum"])
+        if e["payload"] == "struct":
+            w("        const %s* payload = EventPayload<%s>::view(data, length);" % (e["type"], e["type"]))
+            w("        if (payload == nullptr) return false;")
+            w("        handler.on%s(*payload, header);" % e["type"])
+        elif e["payload"] == "none":
+            w("        handler.on%s(header);" % e["type"])
+        else:
+            w("        handler.on%s(data, length, header);" % e["type"])
+        w("        return true;")
+        w("    }")
+    w("    default:")
+    w("        handler.onUnknown(eventName, data, length, header);")
+    w("        return false;")
+    w("    }")
+    w("}")
+    w("")
+    w("// Register handler with EventMsg as deviceName; it must outlive the registration")
+    w("template <typename H>")
+    w("bool registerWith(EventMsg& eventMsg, const char* deviceName, const EventHeader& listen, H& handler) {")
+    w("    return eventMsg.registerDispatcher(deviceName, listen,")
+    w("        [&handler](const char*, const char* eventName, const char* data, size_t length, EventHeader& header) {")
+    w("            dispatch(handler, eventName, data, length, header);")
+    w("        });")
+    w("}")
+    w("")
+    w("// One prepared event per catalog entry, all sent with the same header")
+    w("class Sender {")
+    w("public:")
+    inits = ["%sEvent(eventMsg, \"%s\", header)" % (e["method"], e["name"]) for e in events]
+    w("    Sender(EventMsg& eventMsg, const EventHeader& header)")
+    w("        : " + ",\n          ".join(inits) + " {}")
+    w("")
+    for e in events:
+        m = e["method"]
+        if e["payload"] == "struct":
+            w("    size_t %s(const %s& payload) const { return %sEvent.send(payload); }" % (m, e["type"], m))
+            if not any(f["array"] for f in e["fields"]):
+                params = ", ".join("%s %s" % (f["ctype"], f["name"]) for f in e["fields"])
+                w("    size_t %s(%s) const {" % (m, params))
+                w("        %s payload;" % e["type"])
+                for f in e["fields"]:
+                    w("        payload.%s = %s;" % (f["name"], f["name"]))
+                w("        return %sEvent.send(payload);" % m)
+                w("    }")
+        elif e["payload"] == "none":
+            w("    size_t %s() const {" % m)
+            w("        static const uint8_t empty = 0;")
+            w("        return %sEvent.send(&empty, 0);" % m)
+            w("    }")
+        else:
+            if e["payload"] == "text":
+                w("    size_t %s(const char* text) const { return %sEvent.send(text); }" % (m, m))
+            w("    size_t %s(const uint8_t* data, size_t length) const { return %sEvent.send(data, length); }" % (m, m))
+    w("")
+    w("    bool isValid() const {")
+    w("        return " + "\n            && ".join("%sEvent.isValid()" % e["method"] for e in events) + ";")
+    w("    }")
+    w("")
+    w("private:")
+    for e in events:
+        member = "TypedEvent<%s>" % e["type"] if e["payload"] == "struct" else "PreparedEvent"
+        w("    %s %sEvent;" % (member, e["method"]))
+    w("};")
+    w("")
+    w("} // namespace %s" % namespace)
+    w("")
+    w("#endif // %s" % guard)
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate static event dispatch from a catalog")
+    parser.add_argument("catalog", help="catalog JSON")
+    parser.add_argument("-o", "--output", help="header to write (default: stdout)")
+    args = parser.parse_args()
+
+    try:
+        catalog, namespace, events = load(args.catalog)
+    except CatalogError as e:
+        sys.stderr.write("eventgen: %s\n" % e)
+        return 1
+
+    source = args.catalog.replace("\\", "/").rsplit("/", 1)[-1]
+    header = generate(source, catalog, namespace, events)
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            f.write(header)
+    else:
+        sys.stdout.write(header)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())